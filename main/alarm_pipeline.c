@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/timers.h"
+#include "esp_log.h"
+#include "driver/gpio.h"
+#include "cJSON.h"
+#include "display.h"
+#include "display_power.h"
+#include "icons.h"
+#include "ui_draw.h"
+#include "reminders_store.h"
+#include "ldr_service.h"
+#include "send_email.h"
+#include "mqtt.h"
+#include "snooze.h"
+#include "clock_source.h"
+#include "sntp.h"
+#include "alarm_pipeline.h"
+
+#define TAG "AlarmPipeline"
+
+#define ALARM_QUEUE_LEN     4
+#define ALARM_FEEDBACK_MS   900
+
+typedef struct {
+    AlarmStage stage;
+    uint32_t   timeout_ms;
+    uint16_t   buzz_on_ms;
+    uint16_t   buzz_off_ms;
+} AlarmStageDef;
+
+static const AlarmStageDef stages[] = {
+    { ALARM_STAGE_SCREEN,      CONFIG_ALARM_SCREEN_SECS * 1000,   0,    0   },
+    { ALARM_STAGE_BUZZER,      CONFIG_ALARM_BUZZER_SECS * 1000,   200,  800 },
+    { ALARM_STAGE_BUZZER_LOUD, CONFIG_ALARM_LOUD_SECS * 1000,     1000, 0   },
+    { ALARM_STAGE_NOTIFY,      CONFIG_ALARM_NOTIFY_SECS * 1000,   1000, 0   },
+    { ALARM_STAGE_AUTO_SNOOZE, 0,                                 0,    0   },
+};
+#define NUM_STAGES ((int)(sizeof(stages)/sizeof(stages[0])))
+
+typedef struct {
+    AlarmEventType type;
+    int            arg;
+    AlarmInfo      info;
+} AlarmEvent;
+
+extern TaskHandle_t mail_task;
+
+static QueueHandle_t alarm_q = NULL;
+static TimerHandle_t stage_timer = NULL;
+static TimerHandle_t buzz_timer = NULL;
+static AlarmInfo cur;
+static int stage_idx = -1;
+static volatile AlarmStage cur_stage = ALARM_STAGE_IDLE;
+static volatile bool active = false;
+static volatile bool screen_visible = false;
+static volatile uint32_t stage_seq = 0;
+static const AlarmStageDef *buzz_def = NULL;
+static bool buzz_on = false;
+
+static void stage_timer_cb(TimerHandle_t t) {
+    AlarmEvent ev = { .type = ALARM_EV_TIMEOUT, .arg = (int)stage_seq };
+    xQueueSend(alarm_q, &ev, 0);
+}
+
+static void buzz_timer_cb(TimerHandle_t t) {
+    const AlarmStageDef *d = buzz_def;
+    if (!d) return;
+    buzz_on = !buzz_on;
+    gpio_set_level(LDR_BUZZER_PIN, buzz_on);
+    xTimerChangePeriod(t, pdMS_TO_TICKS(buzz_on ? d->buzz_on_ms : d->buzz_off_ms), 0);
+}
+
+static void buzzer_apply(const AlarmStageDef *d) {
+    xTimerStop(buzz_timer, portMAX_DELAY);
+    buzz_def = NULL;
+    buzz_on = d && d->buzz_on_ms > 0;
+    gpio_set_level(LDR_BUZZER_PIN, buzz_on);
+    if (buzz_on && d->buzz_off_ms > 0) {
+        buzz_def = d;
+        xTimerChangePeriod(buzz_timer, pdMS_TO_TICKS(d->buzz_on_ms), portMAX_DELAY);
+    }
+}
+
+static void stage_timer_arm(uint32_t ms) {
+    xTimerStop(stage_timer, portMAX_DELAY);
+    stage_seq++;
+    if (ms > 0) xTimerChangePeriod(stage_timer, pdMS_TO_TICKS(ms), portMAX_DELAY);
+}
+
+static void draw_alarm_screen(void) {
+    if (ui_state != UI_IDLE) return;
+    fill_screen(COLOR_BLACK);
+    draw_string(10, 10, "NHAC NHO:", COLOR_GREEN);
+    draw_sprite(TFT_WIDTH - 10 - icon_bell.w, 9, &icon_bell, COLOR_BLACK);
+    draw_string(10, 40, cur.time, COLOR_WHITE);
+    if (cur.snooze_count > 0) {
+        char cnt[8]; snprintf(cnt, sizeof(cnt), "x%d", cur.snooze_count);
+        draw_sprite(56, 39, &icon_snooze, COLOR_BLACK);
+        draw_string(56 + icon_snooze.w + 4, 40, cnt, COLOR_WHITE);
+    }
+    draw_string(10, 70, cur.content, COLOR_WHITE);
+    draw_string(10, 90, cur.date, COLOR_YELLOW);
+    screen_visible = true;
+}
+
+static void notify_escalation(void) {
+    if (cur.snooze_count == 0 && mail_task == NULL) {
+        xTaskCreatePinnedToCore(send_email, "mail_alarm_due", 12288, NULL, 2, &mail_task, 1);
+    }
+    cJSON *j = cJSON_CreateObject();
+    cJSON_AddNumberToObject(j, "id", cur.id);
+    cJSON_AddStringToObject(j, "content", cur.content);
+    cJSON_AddStringToObject(j, "time", cur.time);
+    cJSON_AddNumberToObject(j, "snooze_count", cur.snooze_count);
+    char *s = cJSON_PrintUnformatted(j);
+    if (s) {
+        mqtt_publish("reminders/alarm", s, 0, 0);
+        free(s);
+    }
+    cJSON_Delete(j);
+}
+
+static bool alarm_snooze(void) {
+    // Chỉ hẹn lại trong hàng đợi báo lại; giữ nguyên trạng thái để lịch một lần không thành lịch hằng ngày
+    xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+    bool found = reminder_index_of_locked(cur.id) >= 0;
+    xSemaphoreGive(reminders_mutex);
+    return found && snooze_schedule(cur.id, clock_now() + SNOOZE_SECS, cur.snooze_count + 1);
+}
+
+static void alarm_complete(void) {
+    xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+    if (reminder_index_of_locked(cur.id) >= 0) {
+        update_reminder_status(cur.id, "completed");
+    }
+    xSemaphoreGive(reminders_mutex);
+    snooze_cancel(cur.id);
+}
+
+static void finish(const char *msg, uint16_t color, const Sprite *icon) {
+    buzzer_apply(NULL);
+    ldr_gl5537_set_enabled(&ldr, false);
+    active = false;
+    stage_idx = -1;
+    if (msg && ui_state == UI_IDLE) {
+        show_alarm_feedback(msg, color, icon);
+        screen_visible = true;
+        cur_stage = ALARM_STAGE_FEEDBACK;
+        stage_timer_arm(ALARM_FEEDBACK_MS);
+        return;
+    }
+    stage_timer_arm(0);
+    cur_stage = ALARM_STAGE_IDLE;
+    screen_visible = false;
+    idle_screen_invalidate();
+}
+
+static void finish_snooze(void) {
+    if (alarm_snooze()) {
+        char msg[24]; snprintf(msg, sizeof(msg), "BAO LAI SAU %d PHUT", SNOOZE_SECS / 60);
+        finish(msg, COLOR_YELLOW, &icon_snooze);
+    } else {
+        finish("HET LUOT BAO LAI", COLOR_RED, NULL);
+    }
+}
+
+static void enter_stage(int idx) {
+    stage_idx = idx;
+    const AlarmStageDef *d = &stages[idx];
+    cur_stage = d->stage;
+    ESP_LOGI(TAG, "Báo thức ID %d: giai đoạn %d", cur.id, (int)d->stage);
+    buzzer_apply(d);
+    stage_timer_arm(d->timeout_ms);
+    switch (d->stage) {
+    case ALARM_STAGE_SCREEN:
+        draw_alarm_screen();
+        break;
+    case ALARM_STAGE_NOTIFY:
+        notify_escalation();
+        break;
+    case ALARM_STAGE_AUTO_SNOOZE:
+        finish_snooze();
+        break;
+    default:
+        break;
+    }
+}
+
+static void handle_event(const AlarmEvent *ev) {
+    switch (ev->type) {
+    case ALARM_EV_START:
+        cur = ev->info;
+        ldr_gl5537_set_enabled(&ldr, true);
+        enter_stage(0);
+        break;
+    case ALARM_EV_TIMEOUT:
+        if ((uint32_t)ev->arg != stage_seq) break;
+        if (cur_stage == ALARM_STAGE_FEEDBACK) {
+            finish(NULL, 0, NULL);
+        } else if (stage_idx >= 0 && stage_idx + 1 < NUM_STAGES) {
+            enter_stage(stage_idx + 1);
+        }
+        break;
+    case ALARM_EV_GESTURE:
+        if (!active) break;
+        if (ev->arg == 2) finish_snooze();
+        else if (ev->arg == 0) { alarm_complete(); finish("DA HOAN THANH", COLOR_GREEN, &icon_done); }
+        else if (ev->arg == 1) buzzer_apply(NULL);
+        break;
+    case ALARM_EV_CANCEL: {
+        if (!active) break;
+        bool is_rep = false;
+        xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+        int idx = reminder_index_of_locked(cur.id);
+        if (idx >= 0) is_rep = (strncasecmp(reminders[idx].status, "repeat", 6) == 0);
+        xSemaphoreGive(reminders_mutex);
+        if (is_rep) snooze_schedule(cur.id, clock_now() + SNOOZE_SECS, cur.snooze_count + 1);
+        else snooze_cancel(cur.id);
+        finish(NULL, 0, NULL);
+        break;
+    }
+    case ALARM_EV_DISMISS:
+        if (!active) break;
+        finish(NULL, 0, NULL);
+        break;
+    }
+}
+
+static void alarm_pipeline_task(void *pv) {
+    AlarmEvent ev;
+    for (;;) {
+        if (xQueueReceive(alarm_q, &ev, portMAX_DELAY) == pdTRUE) {
+            handle_event(&ev);
+            display_flush();
+        }
+    }
+}
+
+void alarm_pipeline_init(void) {
+    if (alarm_q) return;
+    alarm_q     = xQueueCreate(ALARM_QUEUE_LEN, sizeof(AlarmEvent));
+    stage_timer = xTimerCreate("alarm_stage", 1, pdFALSE, NULL, stage_timer_cb);
+    buzz_timer  = xTimerCreate("alarm_buzz", 1, pdTRUE, NULL, buzz_timer_cb);
+    xTaskCreatePinnedToCore(alarm_pipeline_task, "alarm_pl", 4096, NULL, 6, NULL, 0);
+}
+
+bool alarm_pipeline_start(const AlarmInfo *info) {
+    if (!alarm_q || active) return false;
+    AlarmEvent ev = { .type = ALARM_EV_START, .info = *info };
+    active = true;
+    screen_visible = (ui_state == UI_IDLE);
+    if (xQueueSend(alarm_q, &ev, pdMS_TO_TICKS(100)) != pdTRUE) {
+        active = false;
+        screen_visible = false;
+        return false;
+    }
+    display_power_activity();
+    return true;
+}
+
+void alarm_pipeline_post(AlarmEventType type, int arg) {
+    if (!alarm_q) return;
+    AlarmEvent ev = { .type = type, .arg = arg };
+    xQueueSend(alarm_q, &ev, pdMS_TO_TICKS(100));
+}
+
+void alarm_pipeline_on_gesture(int code) {
+    alarm_pipeline_post(ALARM_EV_GESTURE, code);
+}
+
+bool alarm_pipeline_active(void) {
+    return active;
+}
+
+bool alarm_pipeline_screen_visible(void) {
+    return screen_visible;
+}
+
+AlarmStage alarm_pipeline_stage(void) {
+    return cur_stage;
+}
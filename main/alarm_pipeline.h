@@ -0,0 +1,38 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+typedef enum {
+    ALARM_STAGE_IDLE = 0,
+    ALARM_STAGE_SCREEN,
+    ALARM_STAGE_BUZZER,
+    ALARM_STAGE_BUZZER_LOUD,
+    ALARM_STAGE_NOTIFY,
+    ALARM_STAGE_AUTO_SNOOZE,
+    ALARM_STAGE_FEEDBACK
+} AlarmStage;
+
+typedef enum {
+    ALARM_EV_START = 0,
+    ALARM_EV_GESTURE,
+    ALARM_EV_DISMISS,
+    ALARM_EV_CANCEL,
+    ALARM_EV_TIMEOUT
+} AlarmEventType;
+
+typedef struct {
+    int  id;
+    int  snooze_count;
+    char time[6];
+    char date[11];
+    char content[64];
+} AlarmInfo;
+
+void alarm_pipeline_init(void);
+bool alarm_pipeline_start(const AlarmInfo *info);
+void alarm_pipeline_post(AlarmEventType type, int arg);
+void alarm_pipeline_on_gesture(int code);
+bool alarm_pipeline_active(void);
+bool alarm_pipeline_screen_visible(void);
+AlarmStage alarm_pipeline_stage(void);
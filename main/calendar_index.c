@@ -0,0 +1,82 @@
+#include <string.h>
+#include "civil_time.h"
+#include "calendar_index.h"
+
+typedef struct {
+    int     y, m;
+    int     total;
+    uint8_t count[31];
+} CalMonth;
+
+typedef struct {
+    int  id;
+    int  y, m, d;
+    bool repeat;
+} CalRef;
+
+// Mỗi lịch chiếm tối đa một ngày, nên số tháng có lịch không vượt quá MAX_REMINDERS
+static CalMonth months[MAX_REMINDERS];
+static int months_n = 0;
+static CalRef refs[MAX_REMINDERS];
+static int refs_n = 0;
+static int repeat_count = 0;
+
+static CalMonth *month_find(int y, int m) {
+    for (int i = 0; i < months_n; i++) {
+        if (months[i].y == y && months[i].m == m) return &months[i];
+    }
+    return NULL;
+}
+
+static void month_add(int y, int m, int d, int delta) {
+    CalMonth *cm = month_find(y, m);
+    if (!cm) {
+        if (delta < 0 || months_n >= MAX_REMINDERS) return;
+        cm = &months[months_n++];
+        memset(cm, 0, sizeof(*cm));
+        cm->y = y; cm->m = m;
+    }
+    cm->count[d-1] += delta;
+    cm->total += delta;
+    if (cm->total == 0) *cm = months[--months_n];
+}
+
+static void ref_drop(int i) {
+    if (refs[i].repeat) repeat_count--;
+    else month_add(refs[i].y, refs[i].m, refs[i].d, -1);
+    refs[i] = refs[--refs_n];
+}
+
+void calendar_index_remove_locked(int id) {
+    for (int i = 0; i < refs_n; i++) {
+        if (refs[i].id == id) { ref_drop(i); return; }
+    }
+}
+
+void calendar_index_put_locked(const Reminder *r) {
+    calendar_index_remove_locked(r->id);
+    if (strncmp(r->status, "completed", 9) == 0 || refs_n >= MAX_REMINDERS) return;
+    CalRef ref = { .id = r->id, .repeat = strncmp(r->status, "repeat", 6) == 0 };
+    if (ref.repeat) {
+        repeat_count++;
+    } else {
+        if (!civil_parse_date(r->date, &ref.y, &ref.m, &ref.d)) return;
+        month_add(ref.y, ref.m, ref.d, +1);
+    }
+    refs[refs_n++] = ref;
+}
+
+void calendar_index_rebuild_locked(void) {
+    months_n = refs_n = repeat_count = 0;
+    for (int i = 0; i < num_reminders; i++) calendar_index_put_locked(&reminders[i]);
+}
+
+int calendar_index_month_locked(int y, int m, uint8_t occ[31]) {
+    int days = civil_days_in_month(y, m);
+    const CalMonth *cm = month_find(y, m);
+    for (int d = 0; d < days; d++) {
+        int n = repeat_count + (cm ? cm->count[d] : 0);
+        occ[d] = (uint8_t)(n > 255 ? 255 : n);
+    }
+    return days;
+}
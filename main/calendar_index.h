@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include "reminders_store.h"
+
+void calendar_index_rebuild_locked(void);
+void calendar_index_put_locked(const Reminder *r);
+void calendar_index_remove_locked(int id);
+int  calendar_index_month_locked(int y, int m, uint8_t occ[31]);
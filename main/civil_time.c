@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "civil_time.h"
+
+#define TAG "CivilTime"
+
+static const uint8_t month_days[12] = { 31,28,31,30,31,30,31,31,30,31,30,31 };
+static const uint16_t days_before_month[12] = { 0,31,59,90,120,151,181,212,243,273,304,334 };
+
+bool civil_is_leap(int y) {
+    return ((y % 4 == 0) && (y % 100 != 0)) || (y % 400 == 0);
+}
+
+int civil_days_in_month(int y, int m) {
+    if (m < 1 || m > 12) return 0;
+    return month_days[m-1] + (m == 2 && civil_is_leap(y));
+}
+
+int32_t days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153u * (unsigned)(m > 2 ? m - 3 : m + 9) + 2) / 5 + (unsigned)d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+void civil_from_days(int32_t z, int *y, int *m, int *d) {
+    z += 719468;
+    const int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    const unsigned doy = doe - (365*yoe + yoe/4 - yoe/100);
+    const unsigned mp  = (5*doy + 2) / 153;
+    const int mm = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *d = (int)(doy - (153*mp + 2)/5 + 1);
+    *m = mm;
+    *y = (int)yoe + era * 400 + (mm <= 2);
+}
+
+time_t civil_mktime(int y, int m, int d, int hh, int mm, int ss, int32_t utc_offset) {
+    return (time_t)days_from_civil(y, m, d) * 86400 + hh * 3600 + mm * 60 + ss - utc_offset;
+}
+
+void civil_localtime(time_t t, int32_t utc_offset, struct tm *out) {
+    int64_t s = (int64_t)t + utc_offset;
+    int32_t days = (int32_t)(s / 86400);
+    int32_t rem  = (int32_t)(s % 86400);
+    if (rem < 0) { rem += 86400; days--; }
+    int y, m, d;
+    civil_from_days(days, &y, &m, &d);
+    out->tm_year  = y - 1900;
+    out->tm_mon   = m - 1;
+    out->tm_mday  = d;
+    out->tm_hour  = rem / 3600;
+    out->tm_min   = (rem / 60) % 60;
+    out->tm_sec   = rem % 60;
+    out->tm_wday  = (int)((days % 7 + 11) % 7);
+    out->tm_yday  = days_before_month[m-1] + d - 1 + (m > 2 && civil_is_leap(y));
+    out->tm_isdst = 0;
+}
+
+static bool parse_digits(const char *s, int n, int *out) {
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        v = v*10 + (s[i] - '0');
+    }
+    *out = v;
+    return true;
+}
+
+bool civil_parse_date(const char *s, int *y, int *m, int *d) {
+    int yy, mm, dd;
+    if (!s || strnlen(s, 11) != 10 || s[4] != '-' || s[7] != '-') return false;
+    if (!parse_digits(s, 4, &yy) || !parse_digits(s+5, 2, &mm) || !parse_digits(s+8, 2, &dd)) return false;
+    if (mm < 1 || mm > 12 || dd < 1 || dd > civil_days_in_month(yy, mm)) return false;
+    *y = yy; *m = mm; *d = dd;
+    return true;
+}
+
+#if CONFIG_REMINDER_CALENDAR_BENCH
+#include "esp_cpu.h"
+
+#define BENCH_N 20000
+
+void civil_bench_run(void) {
+    const int32_t off = 7 * 3600;
+    const time_t base = civil_mktime(2025, 1, 1, 0, 0, 0, off);
+    volatile int sink = 0;
+    struct tm tm;
+
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_N; i++) {
+        time_t t = base + (time_t)i * 1589;
+        localtime_r(&t, &tm);
+        sink += tm.tm_min;
+    }
+    uint32_t c1 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_N; i++) {
+        civil_localtime(base + (time_t)i * 1589, off, &tm);
+        sink += tm.tm_min;
+    }
+    uint32_t c2 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_N; i++) {
+        struct tm ev = { .tm_year = 125, .tm_mon = i % 12, .tm_mday = 1 + i % 28,
+                         .tm_hour = i % 24, .tm_min = i % 60, .tm_isdst = -1 };
+        sink += (int)mktime(&ev);
+    }
+    uint32_t c3 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_N; i++) {
+        sink += (int)civil_mktime(2025, 1 + i % 12, 1 + i % 28, i % 24, i % 60, 0, off);
+    }
+    uint32_t c4 = esp_cpu_get_cycle_count();
+    (void)sink;
+    ESP_LOGI(TAG, "localtime_r: %lu cyc/call, civil_localtime: %lu cyc/call",
+             (unsigned long)((c1 - c0) / BENCH_N), (unsigned long)((c2 - c1) / BENCH_N));
+    ESP_LOGI(TAG, "mktime: %lu cyc/call, civil_mktime: %lu cyc/call",
+             (unsigned long)((c3 - c2) / BENCH_N), (unsigned long)((c4 - c3) / BENCH_N));
+}
+
+#else
+
+void civil_bench_run(void) {
+    ESP_LOGW(TAG, "CONFIG_REMINDER_CALENDAR_BENCH chưa bật");
+}
+
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+bool    civil_is_leap(int y);
+int     civil_days_in_month(int y, int m);
+int32_t days_from_civil(int y, int m, int d);
+void    civil_from_days(int32_t z, int *y, int *m, int *d);
+time_t  civil_mktime(int y, int m, int d, int hh, int mm, int ss, int32_t utc_offset);
+void    civil_localtime(time_t t, int32_t utc_offset, struct tm *out);
+bool    civil_parse_date(const char *s, int *y, int *m, int *d);
+void    civil_bench_run(void);
@@ -0,0 +1,63 @@
+#include <stddef.h>
+#include <time.h>
+#include "clock_source.h"
+#include "civil_time.h"
+#include "tz.h"
+
+static time_t system_now(void *ctx) {
+    (void)ctx;
+    time_t t;
+    time(&t);
+    return t;
+}
+
+static volatile time_t virtual_now = 0;
+
+static time_t virtual_clock_now(void *ctx) {
+    (void)ctx;
+    return virtual_now;
+}
+
+static const ClockSource system_source  = { system_now, NULL };
+static const ClockSource virtual_source = { virtual_clock_now, NULL };
+static ClockSource active = { system_now, NULL };
+
+void clock_set_source(const ClockSource *src) {
+    if (!src || !src->now) src = &system_source;
+    active = *src;
+}
+
+void clock_use_system(void) {
+    clock_set_source(&system_source);
+}
+
+void clock_use_virtual(time_t start) {
+    virtual_now = start;
+    clock_set_source(&virtual_source);
+}
+
+void clock_virtual_set(time_t t) {
+    virtual_now = t;
+}
+
+void clock_virtual_advance(time_t secs) {
+    virtual_now += secs;
+}
+
+bool clock_is_virtual(void) {
+    return active.now == virtual_clock_now;
+}
+
+time_t clock_now(void) {
+    return active.now(active.ctx);
+}
+
+void clock_localtime(time_t t, struct tm *out) {
+    civil_localtime(t, tz_offset_at(t), out);
+}
+
+void clock_now_local(time_t *now, struct tm *out) {
+    time_t t = clock_now();
+    if (now) *now = t;
+    clock_localtime(t, out);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <stdbool.h>
+#include <time.h>
+
+typedef time_t (*clock_now_fn)(void *ctx);
+
+typedef struct {
+    clock_now_fn now;
+    void *ctx;
+} ClockSource;
+
+void clock_set_source(const ClockSource *src);
+void clock_use_system(void);
+void clock_use_virtual(time_t start);
+void clock_virtual_set(time_t t);
+void clock_virtual_advance(time_t secs);
+bool clock_is_virtual(void);
+
+time_t clock_now(void);
+void clock_localtime(time_t t, struct tm *out);
+void clock_now_local(time_t *now, struct tm *out);
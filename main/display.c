@@ -1,12 +1,22 @@
 #define TAG "TimeSync"
 
 #include <stdint.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "font.h"
+#include "glyph.h"
+#include "gfx.h"
 #include "freertos/task.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#include "display.h"
+#include "display_model.h"
 
 #define PIN_NUM_MISO   -1  
 #define PIN_NUM_MOSI   9   
@@ -16,21 +26,9 @@
 #define PIN_NUM_RST    18  
 #define PIN_NUM_BL     17  
 
-#define TFT_WIDTH   128
-#define TFT_HEIGHT  160
-#define OFFSET_X    2   
-#define OFFSET_Y    1   
-#define FONT_W  6
-#define FONT_H  8
-
-#define COLOR_RED    0xF800
-#define COLOR_GREEN  0x07E0
-#define COLOR_BLUE   0x001F
-#define COLOR_BLACK  0x0000
-#define COLOR_WHITE  0xFFFF
-
 #define ST7735_NOP      0x00
 #define ST7735_SWRESET  0x01
+#define ST7735_SLPIN    0x10
 #define ST7735_SLPOUT   0x11
 #define ST7735_COLMOD   0x3A
 #define ST7735_MADCTL   0x36
@@ -38,134 +36,1090 @@
 #define ST7735_RASET    0x2B
 #define ST7735_RAMWR    0x2C
 #define ST7735_DISPON   0x29
+#define ST7735_FRMCTR1  0xB1
+#define ST7735_FRMCTR2  0xB2
+#define ST7735_FRMCTR3  0xB3
+#define ST7735_INVCTR   0xB4
+#define ST7735_PWCTR1   0xC0
+#define ST7735_PWCTR2   0xC1
+#define ST7735_PWCTR3   0xC2
+#define ST7735_PWCTR4   0xC3
+#define ST7735_PWCTR5   0xC4
+#define ST7735_VMCTR1   0xC5
+#define ST7735_GMCTRP1  0xE0
+#define ST7735_GMCTRN1  0xE1
+#define ST7735_VSCRDEF  0x33
+#define ST7735_VSCRSADD 0x37
+#define ST7735_GRAM_H   162
+// MADCTL MY lật hàng nên vùng cố định trên [0, top) nằm ở đáy GRAM, còn hàng hiển thị 0 là hàng GRAM OFFSET_Y
+// như cửa sổ ghi ở set_addr_window. Mới kiểm qua display_model, cần xác nhận trên panel thật (nhất là khi đổi OFFSET_Y)
+#define SCROLL_TFA(top, h) (ST7735_GRAM_H - OFFSET_Y - (top) - (h))
 
-static spi_device_handle_t spi;
+#define DIRTY_MAX        8
+#define DIRTY_SLACK_PX   128
+#define DISP_QUEUE_DEPTH 10
+#define LINE_BUF_PX      (TFT_WIDTH * 16)
+#define SPI_TX_MAX       32768   // trường độ dài dữ liệu SPI của ESP32-S3 chỉ 18 bit
+#define FB_TX_ROWS       (SPI_TX_MAX / (TFT_WIDTH * 2))
+#define LINE_BUFS        CONFIG_DISPLAY_LINE_BUFS
+#define DISP_CMD_QUEUE_LEN CONFIG_DISPLAY_CMD_QUEUE_LEN
+#define DISP_BATCH       16
+#define DISP_TEXT_MAX    64
+#define DISP_TASK_STACK_SIZE 4096
+#define DISP_TASK_PRIORITY   7
+#define DISP_TASK_CORE_ID    1
+#define BL_LEDC_TIMER    LEDC_TIMER_1
+#define BL_LEDC_CHANNEL  LEDC_CHANNEL_2
+#define BL_PWM_HZ        5000
+#define SLEEP_GUARD_MS   120
+#define BIG_GLYPH_W      (5 * BIG_SCALE)
+#define BIG_GLYPH_PX     (BIG_GLYPH_W * BIG_H)
+#define BIG_GLYPHS       11
 
-void send_cmd(uint8_t cmd) {
-    esp_err_t ret;
-    spi_transaction_t t = {
-        .length = 8,
-        .tx_buffer = &cmd,
-        .flags = 0
+typedef struct { int16_t x0, y0, x1, y1; } Rect;
+
+// Một đoạn hàng liên tục trong GRAM: y là hàng ghi, src là hàng tương ứng tính từ đầu dải hiển thị
+typedef struct { int16_t y, h, src; } RowSeg;
+
+// Một bước trong chuỗi lệnh ST7735: dc = 0 là lệnh, 1 là dữ liệu
+typedef struct {
+    const void *buf;
+    uint16_t    len;
+    uint8_t     dc;
+} DispTx;
+
+typedef enum {
+    DCMD_FILL_RECT,
+    DCMD_FILL_SCREEN,
+    DCMD_PIXEL,
+    DCMD_TEXT,
+    DCMD_TEXT_BG,
+    DCMD_FLUSH,
+    DCMD_SYNC,
+    DCMD_PALETTE,
+    DCMD_SCROLL_AREA,
+    DCMD_SCROLL,
+    DCMD_BIG_TEXT,
+    DCMD_STRIP,
+    DCMD_BACKLIGHT,
+    DCMD_SLEEP,
+    DCMD_MARK,
+    DCMD_SPRITE,
+} DispOp;
+
+typedef struct {
+    uint8_t  op;
+    int16_t  x, y;
+    uint16_t w, h;
+    uint16_t fg, bg;
+    union {
+        char text[DISP_TEXT_MAX];
+        TaskHandle_t waiter;
+        uint32_t tag;
+        const Sprite *sprite;
+        uint16_t pal[16];
     };
-    gpio_set_level(PIN_NUM_DC, 0); 
-    ret = spi_device_polling_transmit(spi, &t);
+} DispCmd;
+
+typedef struct {
+    uint8_t  cmd;
+    uint8_t  len;
+    uint8_t  data[16];
+    uint16_t delay_ms;
+} InitCmd;
+
+typedef struct {
+    uint16_t *px;
+    uint32_t  seq;
+} LineBuf;
+
+static const InitCmd st7735_init_seq[] = {
+    { ST7735_NOP,     0, {0}, 0 },
+    { ST7735_SWRESET, 0, {0}, 150 },
+    { ST7735_SLPOUT,  0, {0}, 120 },
+    { ST7735_FRMCTR1, 3, {0x05, 0x3C, 0x3C}, 0 },
+    { ST7735_FRMCTR2, 3, {0x05, 0x3C, 0x3C}, 0 },
+    { ST7735_FRMCTR3, 6, {0x05, 0x3C, 0x3C, 0x05, 0x3C, 0x3C}, 0 },
+    { ST7735_INVCTR,  1, {0x03}, 0 },
+    { ST7735_PWCTR1,  3, {0xA2, 0x02, 0x84}, 0 },
+    { ST7735_PWCTR2,  1, {0xC5}, 0 },
+    { ST7735_PWCTR3,  2, {0x0A, 0x00}, 0 },
+    { ST7735_PWCTR4,  2, {0x8A, 0x2A}, 0 },
+    { ST7735_PWCTR5,  2, {0x8A, 0xEE}, 0 },
+    { ST7735_VMCTR1,  1, {0x0E}, 0 },
+    { ST7735_COLMOD,  1, {0x05}, 0 },
+    { ST7735_MADCTL,  1, {0xC0}, 0 },
+    { ST7735_GMCTRP1, 16, {0x0F, 0x1A, 0x0F, 0x18, 0x2F, 0x28, 0x20, 0x22, 0x1F, 0x1B, 0x23, 0x37, 0x00, 0x07, 0x02, 0x10}, 0 },
+    { ST7735_GMCTRN1, 16, {0x0F, 0x1B, 0x0F, 0x17, 0x33, 0x2C, 0x29, 0x2E, 0x30, 0x30, 0x39, 0x3F, 0x00, 0x07, 0x03, 0x10}, 0 },
+    { ST7735_DISPON,  0, {0}, 10 },
+};
+
+static spi_device_handle_t spi;
+static DisplayStats stats;
+#if CONFIG_DISPLAY_FB_PAL4
+// Mỗi byte chứa 2 điểm ảnh: x chẵn ở nibble cao, x lẻ ở nibble thấp
+typedef uint8_t FbColor;
+static uint8_t *fb = NULL;
+#define FB_BYTES (TFT_WIDTH * TFT_HEIGHT / 2)
+#else
+typedef uint16_t FbColor;
+static uint16_t *fb = NULL;
+#define FB_BYTES (TFT_WIDTH * TFT_HEIGHT * 2)
+#endif
+static SemaphoreHandle_t fb_mutex = NULL;
+static Rect dirty[DIRTY_MAX];
+static int dirty_n = 0;
+
+// Vùng cuộn theo tọa độ hiển thị; nội dung hàng ghi r đang hiện ở hàng top + (r - top + v) mod h
+static int scroll_top = 0, scroll_h = 0, scroll_v = 0;
+static bool scroll_pending = false;
+
+static QueueHandle_t disp_queue = NULL;
+static TaskHandle_t disp_task = NULL;
+static DispCmd batch[DISP_BATCH];
+static SemaphoreHandle_t spi_mutex = NULL;
+static spi_transaction_t trans_pool[DISP_QUEUE_DEPTH];
+static uint32_t queued_seq = 0, done_seq = 0;
+static LineBuf line_bufs[LINE_BUFS];
+static int line_next = 0;
+static DisplayMarkFn mark_hook = NULL;
+static uint32_t mark_bytes = 0;
+static uint8_t bl_level = 255;
+static bool panel_asleep = false;
+static TickType_t sleep_changed = 0;
+static uint16_t *big_cache = NULL;
+static uint16_t big_fg, big_bg;
+static uint32_t big_seq = 0;
+
+static void IRAM_ATTR dc_pre_cb(spi_transaction_t *t) {
+    gpio_set_level(PIN_NUM_DC, (int)(intptr_t)t->user);
+}
+
+static inline void disp_lock(void) {
+    if (spi_mutex) xSemaphoreTakeRecursive(spi_mutex, portMAX_DELAY);
+}
+
+static inline void disp_unlock(void) {
+    if (spi_mutex) xSemaphoreGiveRecursive(spi_mutex);
+}
+
+static void tx_reclaim(void) {
+    spi_transaction_t *rt;
+    if (spi_device_get_trans_result(spi, &rt, portMAX_DELAY) == ESP_OK) done_seq++;
+}
+
+static void tx_wait(uint32_t seq) {
+    while ((int32_t)(done_seq - seq) < 0) tx_reclaim();
+}
+
+// Đưa giao dịch vào hàng đợi DMA, trả về số thứ tự để chờ trước khi tái dùng bộ đệm
+static uint32_t tx_queue(const void *buf, size_t len, int dc) {
+    if (queued_seq - done_seq >= DISP_QUEUE_DEPTH) tx_reclaim();
+    spi_transaction_t *t = &trans_pool[queued_seq % DISP_QUEUE_DEPTH];
+    memset(t, 0, sizeof(*t));
+    t->length = len * 8;
+    t->user   = (void *)(intptr_t)dc;
+    if (len <= 4) {
+        t->flags = SPI_TRANS_USE_TXDATA;
+        memcpy(t->tx_data, buf, len);
+    } else {
+        t->tx_buffer = buf;
+    }
+    esp_err_t ret = spi_device_queue_trans(spi, t, portMAX_DELAY);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Write command 0x%02X failed: %s", cmd, esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Queue SPI (%u bytes) failed: %s", (unsigned)len, esp_err_to_name(ret));
+        return done_seq;
     }
+    stats.transactions++;
+    stats.bytes += len;
+#if CONFIG_DISPLAY_MODEL
+    display_model_feed(dc, buf, len);
+#endif
+    return ++queued_seq;
+}
+
+// Xếp cả chuỗi vào hàng đợi một lượt; chỉ thu hồi đủ chỗ trống trước khi bắt đầu
+static uint32_t tx_queue_list(const DispTx *list, int n) {
+    while (queued_seq - done_seq + n > DISP_QUEUE_DEPTH && queued_seq != done_seq) tx_reclaim();
+    uint32_t seq = done_seq;
+    for (int i = 0; i < n; i++) seq = tx_queue(list[i].buf, list[i].len, list[i].dc);
+    return seq;
+}
+
+static uint16_t *line_buf_acquire(int *idx) {
+    LineBuf *lb = &line_bufs[line_next];
+    *idx = line_next;
+    line_next = (line_next + 1) % LINE_BUFS;
+    tx_wait(lb->seq);
+    return lb->px;
+}
+
+static inline void line_buf_release(int idx, uint32_t seq) {
+    line_bufs[idx].seq = seq;
+}
+
+void send_cmd(uint8_t cmd) {
+    disp_lock();
+    tx_queue(&cmd, 1, 0);
+    disp_unlock();
 }
 
 void send_data(uint8_t *data, uint16_t len) {
     if (len == 0) return;
-    esp_err_t ret;
-    spi_transaction_t t = {
-        .length = len * 8,
-        .tx_buffer = data,
-        .flags = 0
-    };
-    gpio_set_level(PIN_NUM_DC, 1); 
-    ret = spi_device_polling_transmit(spi, &t);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Write data (%d bytes) failed: %s", len, esp_err_to_name(ret));
-    }
+    disp_lock();
+    uint32_t seq = tx_queue(data, len, 1);
+    if (len > 4) tx_wait(seq);
+    disp_unlock();
+}
+
+void display_wait_idle(void) {
+    disp_lock();
+    tx_wait(queued_seq);
+    disp_unlock();
+}
+
+void display_stats_get(DisplayStats *out) {
+    *out = stats;
+}
+
+void display_stats_reset(void) {
+    memset(&stats, 0, sizeof(stats));
 }
 
 void set_addr_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
-    uint8_t data[4];
-    send_cmd(ST7735_CASET);
-    data[0] = (x0 + OFFSET_X) >> 8; data[1] = (x0 + OFFSET_X) & 0xFF;
-    data[2] = (x1 + OFFSET_X) >> 8; data[3] = (x1 + OFFSET_X) & 0xFF;
-    send_data(data, 4);
+    static const uint8_t cmds[3] = { ST7735_CASET, ST7735_RASET, ST7735_RAMWR };
+    uint8_t cols[4] = { (x0 + OFFSET_X) >> 8, (x0 + OFFSET_X) & 0xFF, (x1 + OFFSET_X) >> 8, (x1 + OFFSET_X) & 0xFF };
+    uint8_t rows[4] = { (y0 + OFFSET_Y) >> 8, (y0 + OFFSET_Y) & 0xFF, (y1 + OFFSET_Y) >> 8, (y1 + OFFSET_Y) & 0xFF };
+    const DispTx list[5] = {
+        { &cmds[0], 1, 0 }, { cols, 4, 1 },
+        { &cmds[1], 1, 0 }, { rows, 4, 1 },
+        { &cmds[2], 1, 0 },
+    };
+    disp_lock();
+    tx_queue_list(list, 5);
+    disp_unlock();
+}
 
-    send_cmd(ST7735_RASET);
-    data[0] = (y0 + OFFSET_Y) >> 8; data[1] = (y0 + OFFSET_Y) & 0xFF;
-    data[2] = (y1 + OFFSET_Y) >> 8; data[3] = (y1 + OFFSET_Y) & 0xFF;
-    send_data(data, 4);
+static inline int map_y(int y) {
+    if (scroll_v == 0 || y < scroll_top || y >= scroll_top + scroll_h) return y;
+    return scroll_top + (y - scroll_top - scroll_v + scroll_h) % scroll_h;
+}
+
+// Tách dải hàng hiển thị [y, y+h) thành các đoạn liên tục trong GRAM (tối đa 4 khi cắt qua vùng cuộn)
+static int map_rows(int y, int h, RowSeg seg[4]) {
+    int n = 0, src = 0;
+    while (h > 0) {
+        int gy = map_y(y), run = h;
+        if (scroll_v != 0 && y < scroll_top + scroll_h) {
+            if (y < scroll_top) {
+                run = scroll_top - y;
+            } else {
+                int to_end  = scroll_top + scroll_h - y;
+                int to_wrap = scroll_top + scroll_h - gy;
+                run = to_end < to_wrap ? to_end : to_wrap;
+            }
+            if (run > h) run = h;
+        }
+        seg[n].y = gy; seg[n].h = run; seg[n].src = src;
+        n++;
+        y += run; src += run; h -= run;
+    }
+    return n;
+}
+
+static void send_scroll_start(void) {
+    int tfa = SCROLL_TFA(scroll_top, scroll_h);
+    int ssa = tfa + scroll_v;
+    uint8_t d[2] = { ssa >> 8, ssa & 0xFF };
+    const DispTx list[2] = { { (const uint8_t[]){ ST7735_VSCRSADD }, 1, 0 }, { d, 2, 1 } };
+    disp_lock();
+    tx_queue_list(list, 2);
+    disp_unlock();
+}
 
-    send_cmd(ST7735_RAMWR);
+static void scroll_apply(void) {
+    if (fb) scroll_pending = true;
+    else send_scroll_start();
 }
 
 static void push_color_repeat_chunked(uint16_t color, size_t px_count) {
-    static uint16_t buf[256];
-    size_t chunk_px = sizeof(buf)/sizeof(buf[0]);
+    int idx;
+    uint16_t *buf = line_buf_acquire(&idx);
+    size_t chunk_px = (px_count < LINE_BUF_PX) ? px_count : LINE_BUF_PX;
 
-    uint16_t c_be = (color << 8) | (color >> 8);
-    for (size_t i = 0; i < chunk_px; i++) buf[i] = c_be;
+    gfx_fill16(buf, (uint16_t)((color << 8) | (color >> 8)), chunk_px);
 
-    size_t sent = 0;
+    uint32_t seq = 0;
     while (px_count > 0) {
         size_t n = (px_count > chunk_px) ? chunk_px : px_count;
+        seq = tx_queue(buf, n * 2, 1);
+        px_count -= n;
+    }
+    line_buf_release(idx, seq);
+}
 
-        spi_transaction_t t = {
-            .length    = (int)(n * 2 * 8),
-            .tx_buffer = buf,
-            .flags     = 0
-        };
-        gpio_set_level(PIN_NUM_DC, 1);
-        esp_err_t ret = spi_device_polling_transmit(spi, &t);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "push_color_repeat_chunked fail: %s", esp_err_to_name(ret));
-            return;
+static inline uint16_t swap16(uint16_t c) {
+    return (uint16_t)((c << 8) | (c >> 8));
+}
+
+static inline int rect_area(const Rect *r) {
+    return (r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+static inline Rect rect_union(const Rect *a, const Rect *b) {
+    Rect u = {
+        a->x0 < b->x0 ? a->x0 : b->x0, a->y0 < b->y0 ? a->y0 : b->y0,
+        a->x1 > b->x1 ? a->x1 : b->x1, a->y1 > b->y1 ? a->y1 : b->y1
+    };
+    return u;
+}
+
+#if CONFIG_DISPLAY_FB_PAL4
+// Bảng màu logic: chỉ số nào ứng với màu nào khi vẽ; bảng đang dùng có thể đổi (chế độ đêm)
+static const uint16_t pal_keys[16] = {
+    COLOR_BLACK, COLOR_WHITE, COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_YELLOW,
+    0x07FF, 0xF81F, 0xFD20, 0x8410, 0x4208, 0xC618, 0x000F, 0x03E0, 0x7800, 0x7BE0
+};
+static uint16_t lut2[256][2];
+
+static void pal_load(const uint16_t pal[16]) {
+    for (int i = 0; i < 256; i++) {
+        lut2[i][0] = swap16(pal[i >> 4]);
+        lut2[i][1] = swap16(pal[i & 0x0F]);
+    }
+}
+
+static uint8_t pal_index(uint16_t c) {
+    static uint16_t last_c = COLOR_BLACK;
+    static uint8_t last_i = 0;
+    if (c == last_c) return last_i;
+    int best = 0, best_d = INT32_MAX;
+    for (int i = 0; i < 16; i++) {
+        int dr = ((c >> 11) & 0x1F) - ((pal_keys[i] >> 11) & 0x1F);
+        int dg = (((c >> 5) & 0x3F) - ((pal_keys[i] >> 5) & 0x3F)) / 2;
+        int db = (c & 0x1F) - (pal_keys[i] & 0x1F);
+        int d = dr * dr + dg * dg + db * db;
+        if (d < best_d) { best_d = d; best = i; }
+        if (d == 0) break;
+    }
+    last_c = c;
+    last_i = (uint8_t)best;
+    return last_i;
+}
+
+static inline FbColor fb_color(uint16_t c) {
+    return pal_index(c);
+}
+
+static inline void fb_put(int x, int y, FbColor c) {
+    uint8_t *p = &fb[(y * TFT_WIDTH + x) >> 1];
+    *p = (x & 1) ? (uint8_t)((*p & 0xF0) | c) : (uint8_t)((*p & 0x0F) | (c << 4));
+}
+
+static void fb_hline(int x, int y, int w, FbColor c) {
+    if (x & 1) { fb_put(x++, y, c); w--; }
+    uint8_t *p = &fb[(y * TFT_WIDTH + x) >> 1];
+    memset(p, (c << 4) | c, (size_t)(w >> 1));
+    if (w & 1) fb_put(x + w - 1, y, c);
+}
+
+// Giải bảng màu hai điểm ảnh một lần qua bảng tra 256 mục
+static void fb_stage_row(uint16_t *dst, int x, int y, int w) {
+    const uint8_t *p = &fb[(y * TFT_WIDTH + x) >> 1];
+    if (x & 1) { *dst++ = lut2[*p++][1]; w--; }
+    gfx_expand4(dst, p, (size_t)(w >> 1), lut2);
+    if (w & 1) dst[w - 1] = lut2[p[w >> 1]][0];
+}
+#else
+static inline FbColor fb_color(uint16_t c) {
+    return swap16(c);
+}
+
+static inline void fb_put(int x, int y, FbColor c) {
+    fb[y * TFT_WIDTH + x] = c;
+}
+
+static void fb_hline(int x, int y, int w, FbColor c) {
+    gfx_fill16(&fb[y * TFT_WIDTH + x], c, (size_t)w);
+}
+
+static inline void fb_stage_row(uint16_t *dst, int x, int y, int w) {
+    gfx_copy16(dst, &fb[y * TFT_WIDTH + x], (size_t)w);
+}
+#endif
+
+// Gộp vùng mới vào vùng bẩn đã có nếu phần diện tích thừa nhỏ hơn chi phí một lần đặt cửa sổ
+static void dirty_add(int x0, int y0, int x1, int y1) {
+    Rect r = { x0, y0, x1, y1 };
+    xSemaphoreTake(fb_mutex, portMAX_DELAY);
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < dirty_n; i++) {
+            Rect u = rect_union(&r, &dirty[i]);
+            if (rect_area(&u) <= rect_area(&r) + rect_area(&dirty[i]) + DIRTY_SLACK_PX) {
+                r = u;
+                dirty[i] = dirty[--dirty_n];
+                merged = true;
+                break;
+            }
+        }
+    }
+    if (dirty_n == DIRTY_MAX) {
+        int best = 0, best_cost = INT32_MAX;
+        for (int i = 0; i < dirty_n; i++) {
+            Rect u = rect_union(&r, &dirty[i]);
+            int cost = rect_area(&u) - rect_area(&dirty[i]);
+            if (cost < best_cost) { best_cost = cost; best = i; }
         }
+        r = rect_union(&r, &dirty[best]);
+        dirty[best] = dirty[--dirty_n];
+    }
+    dirty[dirty_n++] = r;
+    xSemaphoreGive(fb_mutex);
+}
 
-        px_count -= n;
-        sent += n;
-        if ((sent & (chunk_px * 8 - 1)) == 0) {
-            taskYIELD();
+static uint32_t push_fb_rect(const Rect *r) {
+    int w = r->x1 - r->x0 + 1;
+    set_addr_window(r->x0, r->y0, r->x1, r->y1);
+#if CONFIG_DISPLAY_FB_RGB565
+    if (w == TFT_WIDTH) {
+        uint32_t seq = 0;
+        for (int y = r->y0; y <= r->y1; y += FB_TX_ROWS) {
+            int n = (r->y1 - y + 1 < FB_TX_ROWS) ? (r->y1 - y + 1) : FB_TX_ROWS;
+            seq = tx_queue(&fb[y * TFT_WIDTH], (size_t)w * n * 2, 1);
         }
+        return seq;
     }
+#endif
+    // Chép khối hàng kế tiếp vào bộ đệm còn lại trong khi khối trước đang truyền
+    int rows_per = LINE_BUF_PX / w;
+    for (int y = r->y0; y <= r->y1; y += rows_per) {
+        int n = (r->y1 - y + 1 < rows_per) ? (r->y1 - y + 1) : rows_per;
+        int idx;
+        uint16_t *stage = line_buf_acquire(&idx);
+        for (int k = 0; k < n; k++) fb_stage_row(&stage[k * w], r->x0, y + k, w);
+        line_buf_release(idx, tx_queue(stage, (size_t)w * n * 2, 1));
+    }
+    return 0;
 }
 
-void fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+static void do_flush(void) {
+    if (!fb) return;
+    xSemaphoreTake(fb_mutex, portMAX_DELAY);
+    disp_lock();
+    uint32_t fb_seq = 0;
+    for (int i = 0; i < dirty_n; i++) {
+        uint32_t seq = push_fb_rect(&dirty[i]);
+        if (seq) fb_seq = seq;
+    }
+    // Đổi điểm bắt đầu cuộn sau khi hàng mới đã nằm trong GRAM
+    if (scroll_pending) {
+        send_scroll_start();
+        scroll_pending = false;
+    }
+    // Vùng rộng cả màn hình được DMA đọc thẳng từ framebuffer: chờ xong rồi mới cho vẽ tiếp
+    tx_wait(fb_seq);
+    disp_unlock();
+    dirty_n = 0;
+    xSemaphoreGive(fb_mutex);
+}
+
+static void do_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
     if (x >= TFT_WIDTH || y >= TFT_HEIGHT) return;
     if (x + w > TFT_WIDTH)  w = TFT_WIDTH  - x;
     if (y + h > TFT_HEIGHT) h = TFT_HEIGHT - y;
-    set_addr_window(x, y, x + w - 1, y + h - 1);
-    push_color_repeat_chunked(color, (size_t)w * h);
+    if (w == 0 || h == 0) return;
+    if (x == 0 && y == 0 && w == TFT_WIDTH && h == TFT_HEIGHT && scroll_v) {
+        scroll_v = 0;
+        scroll_apply();
+    }
+    RowSeg seg[4];
+    int n = map_rows(y, h, seg);
+    if (fb) {
+        FbColor c = fb_color(color);
+        for (int i = 0; i < n; i++) {
+            for (int row = seg[i].y; row < seg[i].y + seg[i].h; row++) fb_hline(x, row, w, c);
+            dirty_add(x, seg[i].y, x + w - 1, seg[i].y + seg[i].h - 1);
+        }
+        return;
+    }
+    disp_lock();
+    for (int i = 0; i < n; i++) {
+        set_addr_window(x, seg[i].y, x + w - 1, seg[i].y + seg[i].h - 1);
+        push_color_repeat_chunked(color, (size_t)w * seg[i].h);
+    }
+    disp_unlock();
 }
 
-void fill_screen(uint16_t color) {
+static void do_fill_screen(uint16_t color) {
+    if (fb || scroll_v) {
+        do_fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, color);
+        return;
+    }
+    disp_lock();
     set_addr_window(0, 0, TFT_WIDTH - 1, TFT_HEIGHT - 1);
     push_color_repeat_chunked(color, (size_t)TFT_WIDTH * TFT_HEIGHT);
+    disp_unlock();
 }
 
-void draw_pixel(uint16_t x, uint16_t y, uint16_t color) {
+static void do_draw_pixel(uint16_t x, uint16_t y, uint16_t color) {
     if (x >= TFT_WIDTH || y >= TFT_HEIGHT) return;
+    if (fb) {
+        y = map_y(y);
+        fb_put(x, y, fb_color(color));
+        dirty_add(x, y, x, y);
+        return;
+    }
     uint8_t data[2] = {color >> 8, color & 0xFF};
+    y = map_y(y);
+    disp_lock();
     set_addr_window(x, y, x, y);
     send_data(data, 2);
+    disp_unlock();
 }
 
-void draw_char(char c, int x, int y, uint16_t color) {
-    const uint8_t *bitmap;
-    if (c >= 'A' && c <= 'Z') {
-        bitmap = font5x7[c - 'A'];
+// Dựng cả dòng chữ (ô 6x8) vào bộ đệm rồi đẩy bằng một cửa sổ và một lần truyền; str là UTF-8 dài n byte
+static void blit_text(int x, int y, const char *str, size_t n, uint16_t fg, uint16_t bg) {
+    if (x < 0 || y < 0 || x >= TFT_WIDTH || y >= TFT_HEIGHT || n == 0) return;
+    int gh = TFT_HEIGHT - y < GLYPH_H ? TFT_HEIGHT - y : GLYPH_H;
+    int w = (int)utf8_glyphs(str, n) * FONT_W - 1;
+    if (x + w > TFT_WIDTH) w = TFT_WIDTH - x;
+    if (w <= 0) return;
+    const char *p = str;
+    if (fb) {
+        FbColor f = fb_color(fg), b = fb_color(bg);
+        for (int i = 0; i * FONT_W < w; i++) {
+            uint8_t g[5];
+            glyph_bits(utf8_next(&p), g);
+            for (int col = 0; col < FONT_W && i * FONT_W + col < w; col++) {
+                uint8_t bits = col < 5 ? g[col] : 0;
+                for (int row = 0; row < gh; row++) fb_put(x + i * FONT_W + col, map_y(y + row), (bits & (1 << row)) ? f : b);
+            }
+        }
+        RowSeg seg[4];
+        int n = map_rows(y, gh, seg);
+        for (int i = 0; i < n; i++) dirty_add(x, seg[i].y, x + w - 1, seg[i].y + seg[i].h - 1);
+        return;
+    }
+    disp_lock();
+    int idx;
+    uint16_t *buf = line_buf_acquire(&idx);
+    for (int i = 0; i * FONT_W < w; i++) {
+        const uint16_t *g = glyph_rgb565(utf8_next(&p), fg, bg);
+        int cols = w - i * FONT_W < FONT_W ? w - i * FONT_W : FONT_W;
+        gfx_blit16(&buf[i * FONT_W], w, g, FONT_W, cols, gh);
+    }
+    RowSeg seg[4];
+    int segs = map_rows(y, gh, seg);
+    uint32_t seq = 0;
+    for (int i = 0; i < segs; i++) {
+        set_addr_window(x, seg[i].y, x + w - 1, seg[i].y + seg[i].h - 1);
+        seq = tx_queue(&buf[seg[i].src * w], (size_t)w * seg[i].h * 2, 1);
+    }
+    line_buf_release(idx, seq);
+    disp_unlock();
+}
+
+// Chữ nền trong suốt chỉ có ở chế độ framebuffer; trực tiếp thì tô nền đen
+static void fb_glyph(uint32_t cp, int x, int y, FbColor fc) {
+    uint8_t g[5];
+    glyph_bits(cp, g);
+    int gh = TFT_HEIGHT - y < GLYPH_H ? TFT_HEIGHT - y : GLYPH_H;
+    for (int col = 0; col < 5 && x + col < TFT_WIDTH; col++) {
+        for (int row = 0; row < gh; row++) {
+            if (g[col] & (1 << row)) fb_put(x + col, map_y(y + row), fc);
+        }
+    }
+    RowSeg seg[4];
+    int n = map_rows(y, gh, seg);
+    for (int i = 0; i < n; i++) dirty_add(x, seg[i].y, (x + 4 < TFT_WIDTH) ? x + 4 : TFT_WIDTH - 1, seg[i].y + seg[i].h - 1);
+}
+
+static void do_draw_string(int x, int y, const char *str, uint16_t color) {
+    if (!fb) {
+        blit_text(x, y, str, strlen(str), color, COLOR_BLACK);
+        return;
     }
-    else if (c >= '0' && c <= '9') {
-        bitmap = font5x7[c - '0' + 26]; 
+    if (y < 0 || y >= TFT_HEIGHT) return;
+    FbColor fc = fb_color(color);
+    uint32_t cp;
+    while ((cp = utf8_next(&str)) != 0 && x < TFT_WIDTH) {
+        if (x >= 0) fb_glyph(cp, x, y, fc);
+        x += FONT_W;
     }
-    else {
+}
+
+// '0'..'9' rồi ':'; -1 nếu không phải ký tự đồng hồ
+static int big_index(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    return c == ':' ? 10 : -1;
+}
+
+static inline bool big_bit(int idx, int col, int row) {
+    const uint8_t *g = font5x7[(idx < 10 ? '0' + idx : ':') - FONT_FIRST];
+    return g[col / BIG_SCALE] & (1 << (row / BIG_SCALE));
+}
+
+// Dựng sẵn 11 ô chữ số đã phóng to theo màu, byte đã đảo, để gửi thẳng bằng DMA không cần chép
+static bool big_cache_prepare(uint16_t fg, uint16_t bg) {
+    if (big_cache && fg == big_fg && bg == big_bg) return true;
+    if (!big_cache) {
+        big_cache = heap_caps_malloc(BIG_GLYPHS * BIG_GLYPH_PX * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (!big_cache) {
+            ESP_LOGE(TAG, "Không đủ bộ nhớ cho chữ số lớn");
+            return false;
+        }
+    } else {
+        tx_wait(big_seq);
+    }
+    uint16_t f = swap16(fg), b = swap16(bg);
+    for (int i = 0; i < BIG_GLYPHS; i++) {
+        uint16_t *p = &big_cache[i * BIG_GLYPH_PX];
+        for (int row = 0; row < BIG_H; row++) {
+            for (int col = 0; col < BIG_GLYPH_W; col++) *p++ = big_bit(i, col, row) ? f : b;
+        }
+    }
+    big_fg = fg;
+    big_bg = bg;
+    return true;
+}
+
+// Mỗi ô chữ số là một cửa sổ và một lần truyền; cột khoảng cách giữa các ô không được vẽ
+static void do_big_string(int x, int y, const char *str, uint16_t fg, uint16_t bg) {
+    if (y < 0 || y + BIG_H > TFT_HEIGHT) return;
+    for (; *str && x >= 0 && x + BIG_GLYPH_W <= TFT_WIDTH; str++, x += BIG_W) {
+        int idx = big_index(*str);
+        if (idx < 0) {
+            do_fill_rect(x, y, BIG_GLYPH_W, BIG_H, bg);
+            continue;
+        }
+        if (fb) {
+            FbColor f = fb_color(fg), b = fb_color(bg);
+            for (int row = 0; row < BIG_H; row++) {
+                for (int col = 0; col < BIG_GLYPH_W; col++) fb_put(x + col, map_y(y + row), big_bit(idx, col, row) ? f : b);
+            }
+            RowSeg seg[4];
+            int n = map_rows(y, BIG_H, seg);
+            for (int i = 0; i < n; i++) dirty_add(x, seg[i].y, x + BIG_GLYPH_W - 1, seg[i].y + seg[i].h - 1);
+            continue;
+        }
+        if (!big_cache_prepare(fg, bg)) return;
+        const uint16_t *px = &big_cache[idx * BIG_GLYPH_PX];
+        RowSeg seg[4];
+        int n = map_rows(y, BIG_H, seg);
+        disp_lock();
+        for (int i = 0; i < n; i++) {
+            set_addr_window(x, seg[i].y, x + BIG_GLYPH_W - 1, seg[i].y + seg[i].h - 1);
+            big_seq = tx_queue(&px[seg[i].src * BIG_GLYPH_W], (size_t)BIG_GLYPH_W * seg[i].h * 2, 1);
+        }
+        disp_unlock();
+    }
+}
+
+// Dòng tiêu đề/gợi ý: lấy ảnh 1 bit từ bộ đệm, tô màu và đẩy cả dòng bằng một cửa sổ
+static void do_strip(int y, const char *text, uint16_t fg, uint16_t bg) {
+    if (y < 0 || y + STRIP_H > TFT_HEIGHT) return;
+    const uint8_t *bits = strip_bits(text);
+    if (fb) {
+        FbColor f = fb_color(fg), b = fb_color(bg);
+        for (int row = 0; row < STRIP_H; row++) {
+            const uint8_t *src = &bits[row * STRIP_STRIDE];
+            int fy = map_y(y + row);
+            for (int x = 0; x < TFT_WIDTH; x++) fb_put(x, fy, (src[x / 8] & (0x80 >> (x % 8))) ? f : b);
+        }
+        RowSeg seg[4];
+        int n = map_rows(y, STRIP_H, seg);
+        for (int i = 0; i < n; i++) dirty_add(0, seg[i].y, TFT_WIDTH - 1, seg[i].y + seg[i].h - 1);
         return;
     }
-    for (int col = 0; col < 5; col++) {
-        for (int row = 0; row < 7; row++) {
-            if (bitmap[col] & (1 << row)) {
-                draw_pixel(x + col, y + row, color);
+    disp_lock();
+    int idx;
+    uint16_t *buf = line_buf_acquire(&idx);
+    gfx_expand1(buf, bits, TFT_WIDTH * STRIP_H, swap16(fg), swap16(bg));
+    RowSeg seg[4];
+    int segs = map_rows(y, STRIP_H, seg);
+    uint32_t seq = 0;
+    for (int i = 0; i < segs; i++) {
+        set_addr_window(0, seg[i].y, TFT_WIDTH - 1, seg[i].y + seg[i].h - 1);
+        seq = tx_queue(&buf[seg[i].src * TFT_WIDTH], (size_t)TFT_WIDTH * seg[i].h * 2, 1);
+    }
+    line_buf_release(idx, seq);
+    disp_unlock();
+}
+
+typedef struct {
+    const uint8_t *p;
+    int run;
+    uint8_t idx;
+} RleCursor;
+
+// Giải n điểm ảnh kế tiếp thành RGB565 đã đảo byte; loạt có thể vắt qua hai lần gọi
+static void rle_expand(RleCursor *c, uint16_t *dst, int n, const uint16_t lut[16]) {
+    while (n > 0) {
+        if (c->run == 0) {
+            c->idx = *c->p & 0x0F;
+            c->run = (*c->p++ >> 4) + 1;
+        }
+        int k = c->run < n ? c->run : n;
+        gfx_fill16(dst, lut[c->idx], (size_t)k);
+        dst += k;
+        n -= k;
+        c->run -= k;
+    }
+}
+
+// Biểu tượng được giải nén thẳng vào bộ đệm dòng theo từng khối hàng, không giữ bản RGB565 nào;
+// điểm trong suốt (chỉ số 0) lấy màu bg
+static void do_sprite(int x, int y, const Sprite *s, uint16_t bg) {
+    if (!s || x < 0 || y < 0 || x + s->w > TFT_WIDTH || y + s->h > TFT_HEIGHT) return;
+    RleCursor c = { s->rle, 0, 0 };
+    if (fb) {
+        FbColor b = fb_color(bg);
+        for (int row = 0; row < s->h; row++) {
+            int fy = map_y(y + row);
+            for (int col = 0; col < s->w; col++) {
+                if (c.run == 0) {
+                    c.idx = *c.p & 0x0F;
+                    c.run = (*c.p++ >> 4) + 1;
+                }
+                c.run--;
+                fb_put(x + col, fy, c.idx && c.idx < s->colors ? fb_color(s->pal[c.idx]) : b);
             }
         }
+        RowSeg seg[4];
+        int n = map_rows(y, s->h, seg);
+        for (int i = 0; i < n; i++) dirty_add(x, seg[i].y, x + s->w - 1, seg[i].y + seg[i].h - 1);
+        return;
+    }
+    uint16_t lut[16];
+    for (int i = 0; i < 16; i++) lut[i] = swap16(i && i < s->colors ? s->pal[i] : bg);
+    int rows_per = LINE_BUF_PX / s->w;
+    disp_lock();
+    for (int r0 = 0; r0 < s->h; r0 += rows_per) {
+        int n = s->h - r0 < rows_per ? s->h - r0 : rows_per;
+        int idx;
+        uint16_t *buf = line_buf_acquire(&idx);
+        rle_expand(&c, buf, n * s->w, lut);
+        RowSeg seg[4];
+        int segs = map_rows(y + r0, n, seg);
+        uint32_t seq = 0;
+        for (int i = 0; i < segs; i++) {
+            set_addr_window(x, seg[i].y, x + s->w - 1, seg[i].y + seg[i].h - 1);
+            seq = tx_queue(&buf[seg[i].src * s->w], (size_t)s->w * seg[i].h * 2, 1);
+        }
+        line_buf_release(idx, seq);
     }
+    disp_unlock();
 }
 
-void draw_string(uint16_t x, uint16_t y, const char *str, uint16_t color) {
-    int count = 0;
-    while (*str) {
-        draw_char(*str, x, y, color);
-        x += 6;
-        str++;
-        if ((++count & 15) == 0) {
-            taskYIELD();   
+// Lệnh xóa cả màn hình làm mọi lệnh vẽ trước nó trong cùng lô trở nên thừa
+static bool cmd_clears_screen(const DispCmd *c) {
+    if (c->op == DCMD_FILL_SCREEN) return true;
+    return c->op == DCMD_FILL_RECT && c->x == 0 && c->y == 0 && c->w >= TFT_WIDTH && c->h >= TFT_HEIGHT;
+}
+
+// Khai báo vùng cuộn [top, top+h) theo tọa độ hiển thị; gọi ngay sau khi xóa màn hình
+static void do_scroll_area(int top, int h) {
+    if (top < 0 || h <= 0 || top + h > TFT_HEIGHT) return;
+    if (top == scroll_top && h == scroll_h) return;
+    scroll_top = top;
+    scroll_h = h;
+    scroll_v = 0;
+    int tfa = SCROLL_TFA(top, h);
+    uint8_t d[6] = { tfa >> 8, tfa & 0xFF, h >> 8, h & 0xFF, (ST7735_GRAM_H - tfa - h) >> 8, (ST7735_GRAM_H - tfa - h) & 0xFF };
+    const DispTx list[2] = { { (const uint8_t[]){ ST7735_VSCRDEF }, 1, 0 }, { d, 6, 1 } };
+    disp_lock();
+    tx_queue_list(list, 2);
+    tx_wait(queued_seq);
+    disp_unlock();
+    scroll_apply();
+}
+
+// dy > 0: nội dung trôi lên, các hàng lộ ra ở đáy vùng cuộn cần được vẽ lại
+static void do_scroll(int dy) {
+    if (scroll_h == 0) return;
+    scroll_v = ((scroll_v - dy) % scroll_h + scroll_h) % scroll_h;
+    scroll_apply();
+}
+
+static void backlight_apply(uint8_t level) {
+    ledc_set_duty(LEDC_LOW_SPEED_MODE, BL_LEDC_CHANNEL, level);
+    ledc_update_duty(LEDC_LOW_SPEED_MODE, BL_LEDC_CHANNEL);
+}
+
+static void backlight_init(void) {
+    ledc_timer_config_t timer = {
+        .speed_mode      = LEDC_LOW_SPEED_MODE,
+        .duty_resolution = LEDC_TIMER_8_BIT,
+        .timer_num       = BL_LEDC_TIMER,
+        .freq_hz         = BL_PWM_HZ,
+        .clk_cfg         = LEDC_AUTO_CLK,
+    };
+    ledc_channel_config_t ch = {
+        .gpio_num   = PIN_NUM_BL,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .channel    = BL_LEDC_CHANNEL,
+        .intr_type  = LEDC_INTR_DISABLE,
+        .timer_sel  = BL_LEDC_TIMER,
+        .duty       = bl_level,
+        .hpoint     = 0,
+    };
+    if (ledc_timer_config(&timer) != ESP_OK || ledc_channel_config(&ch) != ESP_OK) {
+        ESP_LOGE(TAG, "Không cấu hình được PWM đèn nền, giữ mức cao");
+        gpio_set_direction(PIN_NUM_BL, GPIO_MODE_OUTPUT);
+        gpio_set_level(PIN_NUM_BL, 1);
+        return;
+    }
+    ESP_LOGI(TAG, "Backlight PWM on GPIO %d", PIN_NUM_BL);
+}
+
+static void do_backlight(uint8_t level) {
+    bl_level = level;
+    if (!panel_asleep) backlight_apply(level);
+}
+
+// GRAM vẫn giữ nội dung và vẫn nhận lệnh ghi khi ngủ, nên thức dậy chỉ cần SLPOUT và bật đèn nền
+static void do_sleep(bool on) {
+    if (on == panel_asleep) return;
+    TickType_t since = xTaskGetTickCount() - sleep_changed;
+    if (since < pdMS_TO_TICKS(SLEEP_GUARD_MS)) vTaskDelay(pdMS_TO_TICKS(SLEEP_GUARD_MS) - since);
+    if (on) {
+        do_flush();
+        backlight_apply(0);
+    }
+    uint8_t cmd = on ? ST7735_SLPIN : ST7735_SLPOUT;
+    disp_lock();
+    tx_queue(&cmd, 1, 0);
+    disp_unlock();
+    display_wait_idle();
+    if (!on) backlight_apply(bl_level);
+    panel_asleep = on;
+    sleep_changed = xTaskGetTickCount();
+}
+
+// Đẩy nốt framebuffer, chờ SPI xong rồi báo số byte đã gửi kể từ mốc trước
+static void do_mark(uint32_t tag) {
+    do_flush();
+    display_wait_idle();
+    uint32_t bytes = stats.bytes >= mark_bytes ? stats.bytes - mark_bytes : stats.bytes;
+    mark_bytes = stats.bytes;
+    if (mark_hook) mark_hook(tag, bytes);
+}
+
+static void disp_exec(const DispCmd *c) {
+    switch (c->op) {
+    case DCMD_FILL_RECT:   do_fill_rect(c->x, c->y, c->w, c->h, c->fg); break;
+    case DCMD_FILL_SCREEN: do_fill_screen(c->fg); break;
+    case DCMD_PIXEL:       do_draw_pixel(c->x, c->y, c->fg); break;
+    case DCMD_TEXT:        do_draw_string(c->x, c->y, c->text, c->fg); break;
+    case DCMD_TEXT_BG:     blit_text(c->x, c->y, c->text, strlen(c->text), c->fg, c->bg); break;
+    case DCMD_BIG_TEXT:    do_big_string(c->x, c->y, c->text, c->fg, c->bg); break;
+    case DCMD_STRIP:       do_strip(c->y, c->text, c->fg, c->bg); break;
+    case DCMD_SPRITE:      do_sprite(c->x, c->y, c->sprite, c->bg); break;
+    case DCMD_BACKLIGHT:   do_backlight((uint8_t)c->w); break;
+    case DCMD_SLEEP:       do_sleep(c->w != 0); break;
+    case DCMD_SCROLL_AREA: do_scroll_area(c->y, c->h); break;
+    case DCMD_SCROLL:      do_scroll(c->y); break;
+    default: break;
+    }
+}
+
+static void display_task(void *arg) {
+    for (;;) {
+        if (xQueueReceive(disp_queue, &batch[0], portMAX_DELAY) != pdTRUE) continue;
+        UBaseType_t depth = uxQueueMessagesWaiting(disp_queue) + 1;
+        if (depth > stats.queue_max) stats.queue_max = depth;
+        int n = 1;
+        while (n < DISP_BATCH && xQueueReceive(disp_queue, &batch[n], 0) == pdTRUE) n++;
+
+        int start = 0;
+        for (int i = n - 1; i > 0; i--) {
+            if (cmd_clears_screen(&batch[i])) { start = i; break; }
+        }
+        bool flush = false;
+        for (int i = 0; i < n; i++) {
+            const DispCmd *c = &batch[i];
+            if (c->op == DCMD_FLUSH) {
+                flush = true;
+            } else if (c->op == DCMD_PALETTE) {
+#if CONFIG_DISPLAY_FB_PAL4
+                if (fb) {
+                    pal_load(c->pal);
+                    dirty_add(0, 0, TFT_WIDTH - 1, TFT_HEIGHT - 1);
+                    flush = true;
+                }
+#endif
+            } else if (c->op == DCMD_MARK && i < start) {
+                // Khung của mốc này bị lệnh xoá màn hình phía sau bỏ đi, không có gì ra tới màn hình để đo
+                stats.coalesced++;
+            } else if (c->op == DCMD_MARK) {
+                flush = false;
+                do_mark(c->tag);
+            } else if (c->op == DCMD_SYNC) {
+                if (flush) { do_flush(); flush = false; }
+                display_wait_idle();
+                xTaskNotifyGive(c->waiter);
+            } else if (i < start && c->op != DCMD_SCROLL_AREA && c->op != DCMD_BACKLIGHT && c->op != DCMD_SLEEP) {
+                stats.coalesced++;
+            } else {
+                disp_exec(c);
+            }
         }
+        if (flush) do_flush();
+    }
+}
+
+static void disp_submit(const DispCmd *c) {
+    xQueueSend(disp_queue, c, portMAX_DELAY);
+}
+
+static void disp_submit_text(uint8_t op, int x, int y, const char *str, size_t n, uint16_t fg, uint16_t bg) {
+    DispCmd c = { .op = op, .x = x, .y = y, .fg = fg, .bg = bg };
+    if (n > DISP_TEXT_MAX - 1) {
+        n = DISP_TEXT_MAX - 1;
+        while (n > 0 && (str[n] & 0xC0) == 0x80) n--;
     }
+    memcpy(c.text, str, n);
+    c.text[n] = '\0';
+    disp_submit(&c);
+}
+
+void fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+    if (!disp_queue) { do_fill_rect(x, y, w, h, color); return; }
+    DispCmd c = { .op = DCMD_FILL_RECT, .x = x, .y = y, .w = w, .h = h, .fg = color };
+    disp_submit(&c);
+}
+
+void fill_screen(uint16_t color) {
+    if (!disp_queue) { do_fill_screen(color); return; }
+    DispCmd c = { .op = DCMD_FILL_SCREEN, .fg = color };
+    disp_submit(&c);
+}
+
+void draw_pixel(uint16_t x, uint16_t y, uint16_t color) {
+    if (!disp_queue) { do_draw_pixel(x, y, color); return; }
+    DispCmd c = { .op = DCMD_PIXEL, .x = x, .y = y, .fg = color };
+    disp_submit(&c);
+}
+
+void draw_char(char c, int x, int y, uint16_t color) {
+    if (!disp_queue) { char str[2] = {c, 0}; do_draw_string(x, y, str, color); return; }
+    disp_submit_text(DCMD_TEXT, x, y, &c, 1, color, 0);
+}
+
+void draw_string(uint16_t x, uint16_t y, const char *str, uint16_t color) {
+    if (!disp_queue) { do_draw_string(x, y, str, color); return; }
+    disp_submit_text(DCMD_TEXT, x, y, str, strlen(str), color, 0);
+}
+
+void draw_char_bg(char c, int x, int y, uint16_t color, uint16_t bg) {
+    if (!disp_queue) { blit_text(x, y, &c, 1, color, bg); return; }
+    disp_submit_text(DCMD_TEXT_BG, x, y, &c, 1, color, bg);
+}
+
+void draw_string_bg(uint16_t x, uint16_t y, const char *str, uint16_t color, uint16_t bg) {
+    if (!disp_queue) { blit_text(x, y, str, strlen(str), color, bg); return; }
+    disp_submit_text(DCMD_TEXT_BG, x, y, str, strlen(str), color, bg);
+}
+
+void draw_big_string(int x, int y, const char *str, uint16_t color, uint16_t bg) {
+    if (!disp_queue) { do_big_string(x, y, str, color, bg); return; }
+    disp_submit_text(DCMD_BIG_TEXT, x, y, str, strlen(str), color, bg);
+}
+
+void draw_strip(int y, const char *text, uint16_t color, uint16_t bg) {
+    if (!disp_queue) { do_strip(y, text, color, bg); return; }
+    disp_submit_text(DCMD_STRIP, 0, y, text, strlen(text), color, bg);
+}
+
+void draw_sprite(int x, int y, const Sprite *s, uint16_t bg) {
+    if (!disp_queue) { do_sprite(x, y, s, bg); return; }
+    DispCmd c = { .op = DCMD_SPRITE, .x = x, .y = y, .bg = bg, .sprite = s };
+    disp_submit(&c);
+}
+
+void display_flush(void) {
+    if (!disp_queue) { do_flush(); return; }
+    DispCmd c = { .op = DCMD_FLUSH };
+    disp_submit(&c);
+}
+
+// Chờ tác vụ hiển thị xử lý hết các lệnh đã gửi trước đó và SPI rảnh
+void display_sync(void) {
+    if (!disp_queue || xTaskGetCurrentTaskHandle() == disp_task) {
+        display_wait_idle();
+        return;
+    }
+    DispCmd c = { .op = DCMD_SYNC, .waiter = xTaskGetCurrentTaskHandle() };
+    disp_submit(&c);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+// Chỉ có tác dụng với framebuffer 4 bit: đổi bảng màu rồi gửi lại cả màn hình, không cần vẽ lại
+void display_set_palette(const uint16_t pal[16]) {
+    DispCmd c = { .op = DCMD_PALETTE };
+    memcpy(c.pal, pal, sizeof(c.pal));
+    if (disp_queue) disp_submit(&c);
+#if CONFIG_DISPLAY_FB_PAL4
+    else pal_load(pal);
+#endif
+}
+
+void display_set_night(bool on) {
+    uint16_t pal[16];
+    for (int i = 0; i < 16; i++) {
+        uint16_t c = display_palette_default(i);
+        pal[i] = on ? (uint16_t)((c >> 1) & 0x7BEF) : c;
+    }
+    display_set_palette(pal);
+}
+
+uint16_t display_palette_default(int i) {
+#if CONFIG_DISPLAY_FB_PAL4
+    return pal_keys[i & 0x0F];
+#else
+    static const uint16_t basic[6] = { COLOR_BLACK, COLOR_WHITE, COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_YELLOW };
+    return (i >= 0 && i < 6) ? basic[i] : COLOR_BLACK;
+#endif
+}
+
+void display_scroll_area(int top, int h) {
+    if (!disp_queue) { do_scroll_area(top, h); return; }
+    DispCmd c = { .op = DCMD_SCROLL_AREA, .y = top, .h = h };
+    disp_submit(&c);
+}
+
+void display_scroll(int dy) {
+    if (!disp_queue) { do_scroll(dy); return; }
+    DispCmd c = { .op = DCMD_SCROLL, .y = dy };
+    disp_submit(&c);
+}
+
+void display_set_mark_hook(DisplayMarkFn fn) {
+    mark_hook = fn;
+}
+
+void display_mark(uint32_t tag) {
+    if (!disp_queue) { do_mark(tag); return; }
+    DispCmd c = { .op = DCMD_MARK, .tag = tag };
+    disp_submit(&c);
+}
+
+void display_set_backlight(uint8_t level) {
+    if (!disp_queue) { do_backlight(level); return; }
+    DispCmd c = { .op = DCMD_BACKLIGHT, .w = level };
+    disp_submit(&c);
+}
+
+void display_sleep(bool on) {
+    if (!disp_queue) { do_sleep(on); return; }
+    DispCmd c = { .op = DCMD_SLEEP, .w = on };
+    disp_submit(&c);
+}
+
+UBaseType_t display_queue_depth(void) {
+    return disp_queue ? uxQueueMessagesWaiting(disp_queue) : 0;
 }
 
 void init_spi() {
@@ -185,16 +1139,16 @@ void init_spi() {
         .sclk_io_num = PIN_NUM_CLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = TFT_WIDTH * TFT_HEIGHT * 2 + 8
+        .max_transfer_sz = SPI_TX_MAX
     };
 
     spi_device_interface_config_t devcfg = {
         .clock_speed_hz = 10 * 1000 * 1000,  
         .mode = 0,                         
         .spics_io_num = PIN_NUM_CS,
-        .queue_size = 10,                  
+        .queue_size = DISP_QUEUE_DEPTH,
         .flags = 0,                        
-        .pre_cb = NULL,
+        .pre_cb = dc_pre_cb,
         .post_cb = NULL
     };
 
@@ -213,6 +1167,13 @@ void init_spi() {
         ESP_LOGI(TAG, "SPI device add: OK");
     }
     ESP_ERROR_CHECK(ret);
+
+    if (!spi_mutex) spi_mutex = xSemaphoreCreateRecursiveMutex();
+    for (int i = 0; i < LINE_BUFS; i++) {
+        if (line_bufs[i].px) continue;
+        line_bufs[i].px = heap_caps_aligned_alloc(16, LINE_BUF_PX * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        ESP_ERROR_CHECK(line_bufs[i].px ? ESP_OK : ESP_ERR_NO_MEM);
+    }
 }
 
 void test_gpio() {
@@ -231,7 +1192,7 @@ void test_gpio() {
 
 void init_display() {
     gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << PIN_NUM_DC) | (1ULL << PIN_NUM_RST) | (1ULL << PIN_NUM_BL),
+        .pin_bit_mask = (1ULL << PIN_NUM_DC) | (1ULL << PIN_NUM_RST),
         .mode = GPIO_MODE_OUTPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
@@ -245,8 +1206,7 @@ void init_display() {
     }
     ESP_ERROR_CHECK(ret);
 
-    gpio_set_level(PIN_NUM_BL, 1);
-    ESP_LOGI(TAG, "Backlight set to HIGH (GPIO %d)", PIN_NUM_BL);
+    backlight_init();
 
     test_gpio();
 
@@ -258,48 +1218,40 @@ void init_display() {
 
     init_spi();
 
-    send_cmd(ST7735_NOP);
-    send_cmd(ST7735_SWRESET);
-    vTaskDelay(150 / portTICK_PERIOD_MS);
-
-    send_cmd(ST7735_SLPOUT);
-    vTaskDelay(120 / portTICK_PERIOD_MS);;
-
-    send_cmd(0xB1);
-    send_data((uint8_t[]){0x05, 0x3C, 0x3C}, 3);
-    send_cmd(0xB2);
-    send_data((uint8_t[]){0x05, 0x3C, 0x3C}, 3);
-    send_cmd(0xB3);
-    send_data((uint8_t[]){0x05, 0x3C, 0x3C, 0x05, 0x3C, 0x3C}, 6);
-    
-    send_cmd(0xB4);
-    send_data((uint8_t[]){0x03}, 1);
-
-    send_cmd(0xC0);
-    send_data((uint8_t[]){0xA2, 0x02, 0x84}, 3);
-    send_cmd(0xC1);
-    send_data((uint8_t[]){0xC5}, 1);
-    send_cmd(0xC2);
-    send_data((uint8_t[]){0x0A, 0x00}, 2);
-    send_cmd(0xC3);
-    send_data((uint8_t[]){0x8A, 0x2A}, 2);
-    send_cmd(0xC4);
-    send_data((uint8_t[]){0x8A, 0xEE}, 2);
-    send_cmd(0xC5);
-    send_data((uint8_t[]){0x0E}, 1);
-
-    send_cmd(ST7735_COLMOD);
-    send_data((uint8_t[]){0x05}, 1);
-
-    send_cmd(ST7735_MADCTL);
-    send_data((uint8_t[]){0xC0}, 1); 
-    
-    send_cmd(0xE0);
-    send_data((uint8_t[]){0x0F, 0x1A, 0x0F, 0x18, 0x2F, 0x28, 0x20, 0x22, 0x1F, 0x1B, 0x23, 0x37, 0x00, 0x07, 0x02, 0x10}, 16);                     
-    send_data((uint8_t[]){0x0F, 0x1B, 0x0F, 0x17, 0x33, 0x2C, 0x29, 0x2E, 0x30, 0x30, 0x39, 0x3F, 0x00, 0x07, 0x03, 0x10}, 16);
-
-    send_cmd(ST7735_DISPON);
-    vTaskDelay(10 / portTICK_PERIOD_MS);
+    // Bảng khởi tạo: dữ liệu nằm trong flash, mỗi lệnh kèm dữ liệu được xếp hàng một lượt
+    for (size_t i = 0; i < sizeof(st7735_init_seq) / sizeof(st7735_init_seq[0]); i++) {
+        const InitCmd *c = &st7735_init_seq[i];
+        const DispTx list[2] = { { &c->cmd, 1, 0 }, { c->data, c->len, 1 } };
+        disp_lock();
+        tx_queue_list(list, c->len ? 2 : 1);
+        if (c->delay_ms) tx_wait(queued_seq);
+        disp_unlock();
+        if (c->delay_ms) vTaskDelay(pdMS_TO_TICKS(c->delay_ms));
+    }
+    display_wait_idle();
+
+#if CONFIG_DISPLAY_FB_RGB565 || CONFIG_DISPLAY_FB_PAL4
+    if (!fb) {
+        fb_mutex = xSemaphoreCreateMutex();
+#if CONFIG_DISPLAY_FB_PAL4
+        pal_load(pal_keys);
+#endif
+        fb = heap_caps_aligned_alloc(16, FB_BYTES, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (!fb) ESP_LOGE(TAG, "Không cấp phát được framebuffer, vẽ trực tiếp lên màn hình");
+        else fill_screen(COLOR_BLACK);
+    }
+#endif
+
+    if (!disp_queue) {
+        disp_queue = xQueueCreate(DISP_CMD_QUEUE_LEN, sizeof(DispCmd));
+        if (!disp_queue ||
+            xTaskCreatePinnedToCore(display_task, "display", DISP_TASK_STACK_SIZE, NULL,
+                                    DISP_TASK_PRIORITY, &disp_task, DISP_TASK_CORE_ID) != pdPASS) {
+            ESP_LOGE(TAG, "Không tạo được tác vụ hiển thị, vẽ trực tiếp từ tác vụ gọi");
+            if (disp_queue) vQueueDelete(disp_queue);
+            disp_queue = NULL;
+        }
+    }
 
     ESP_LOGI(TAG, "Display initialized successfully");
 }
\ No newline at end of file
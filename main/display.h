@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "font.h"
 #include "freertos/task.h"
@@ -14,6 +15,25 @@
 #define FONT_W  6
 #define FONT_H  8
 
+// Chữ số đồng hồ cỡ lớn: font 5x7 phóng BIG_SCALE lần, ô rộng BIG_W kể cả khoảng cách
+#define BIG_SCALE  3
+#define BIG_W      (FONT_W * BIG_SCALE)
+#define BIG_H      (7 * BIG_SCALE)
+
+// Dòng tiêu đề/gợi ý dựng sẵn: rộng cả màn hình, chữ bắt đầu từ cột STRIP_TX
+#define STRIP_H       10
+#define STRIP_TX      4
+#define STRIP_STRIDE  (TFT_WIDTH / 8)
+
+// Ảnh nén trong flash (tools/png2sprite.py): mỗi byte rle là (độ dài loạt - 1) << 4 | chỉ số màu,
+// các loạt nối tiếp theo hàng; chỉ số 0 là trong suốt
+typedef struct {
+    uint8_t w, h;
+    uint8_t colors;
+    const uint16_t *pal;
+    const uint8_t *rle;
+} Sprite;
+
 #define COLOR_RED    0xF800
 #define COLOR_GREEN  0x07E0
 #define COLOR_BLUE   0x001F
@@ -21,6 +41,16 @@
 #define COLOR_WHITE  0xFFFF
 #define COLOR_YELLOW 0xFFE0
 
+// Gọi từ tác vụ hiển thị khi mọi lệnh trước display_mark() đã ra tới màn hình
+typedef void (*DisplayMarkFn)(uint32_t tag, uint32_t bytes);
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t queue_max;
+    uint32_t coalesced;
+} DisplayStats;
+
 void send_cmd(uint8_t cmd);
 void send_data(uint8_t *data, uint16_t len);
 void set_addr_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
@@ -29,6 +59,26 @@ void fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void draw_pixel(uint16_t x, uint16_t y, uint16_t color);
 void draw_char(char c, int x, int y, uint16_t color);
 void draw_string(uint16_t x, uint16_t y, const char *str, uint16_t color);
+void draw_char_bg(char c, int x, int y, uint16_t color, uint16_t bg);
+void draw_string_bg(uint16_t x, uint16_t y, const char *str, uint16_t color, uint16_t bg);
+void draw_big_string(int x, int y, const char *str, uint16_t color, uint16_t bg);
+void draw_strip(int y, const char *text, uint16_t color, uint16_t bg);
+void draw_sprite(int x, int y, const Sprite *s, uint16_t bg);
 void init_spi(void);
 void test_gpio(void);
-void init_display(void);
\ No newline at end of file
+void init_display(void);
+void display_flush(void);
+void display_wait_idle(void);
+void display_sync(void);
+void display_set_mark_hook(DisplayMarkFn fn);
+void display_mark(uint32_t tag);
+UBaseType_t display_queue_depth(void);
+void display_set_palette(const uint16_t pal[16]);
+void display_set_night(bool on);
+uint16_t display_palette_default(int i);
+void display_scroll_area(int top, int h);
+void display_scroll(int dy);
+void display_set_backlight(uint8_t level);
+void display_sleep(bool on);
+void display_stats_get(DisplayStats *out);
+void display_stats_reset(void);
\ No newline at end of file
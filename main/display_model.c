@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "display.h"
+#include "display_model.h"
+
+#if CONFIG_DISPLAY_MODEL
+
+// Mô hình ST7735: GRAM 132x162, cửa sổ CASET/RASET và con trỏ ghi RAMWR.
+// MADCTL chỉ được ghi nhận, ảnh xuất ra theo tọa độ logic mà phần mềm dùng.
+#define GRAM_W 132
+#define GRAM_H 162
+
+static uint16_t *gram = NULL;
+static DisplayModelStats mstats;
+static uint8_t cur_cmd = 0;
+static int param_idx = 0;
+static uint8_t params[6];
+static int tfa = 0, vsa = GRAM_H, ssa = 0;
+static int xs = 0, xe = GRAM_W - 1, ys = 0, ye = GRAM_H - 1;
+static int wx = 0, wy = 0;
+static bool ram_write = false;
+static bool have_half = false;
+static uint8_t half;
+
+void display_model_reset(void) {
+    if (!gram) gram = malloc(GRAM_W * GRAM_H * sizeof(uint16_t));
+    if (gram) memset(gram, 0, GRAM_W * GRAM_H * sizeof(uint16_t));
+    memset(&mstats, 0, sizeof(mstats));
+    cur_cmd = 0;
+    param_idx = 0;
+    xs = 0; xe = GRAM_W - 1; ys = 0; ye = GRAM_H - 1;
+    tfa = 0; vsa = GRAM_H; ssa = 0;
+    wx = 0; wy = 0;
+    ram_write = false;
+    have_half = false;
+}
+
+static void model_put(uint16_t c) {
+    if (wx > xe || wy > ye || wx >= GRAM_W || wy >= GRAM_H) {
+        mstats.overflow_pixels++;
+        return;
+    }
+    gram[wy * GRAM_W + wx] = c;
+    mstats.pixels++;
+    if (++wx > xe) {
+        wx = xs;
+        wy++;
+    }
+}
+
+static void model_cmd(uint8_t cmd) {
+    mstats.commands++;
+    if (ram_write) have_half = false;
+    cur_cmd = cmd;
+    param_idx = 0;
+    ram_write = false;
+    switch (cmd) {
+    case 0x01:  // SWRESET
+        xs = 0; xe = GRAM_W - 1; ys = 0; ye = GRAM_H - 1;
+        tfa = 0; vsa = GRAM_H; ssa = 0;
+        break;
+    case 0x2C:  // RAMWR
+        wx = xs; wy = ys;
+        ram_write = true;
+        have_half = false;
+        mstats.windows++;
+        break;
+    default:
+        break;
+    }
+}
+
+static void model_param(uint8_t b) {
+    if (param_idx < 6) params[param_idx] = b;
+    param_idx++;
+    int p0 = (params[0] << 8) | params[1];
+    int p1 = (params[2] << 8) | params[3];
+    switch (cur_cmd) {
+    case 0x2A:  // CASET
+        if (param_idx == 4) { xs = p0; xe = p1; }
+        break;
+    case 0x2B:  // RASET
+        if (param_idx == 4) { ys = p0; ye = p1; }
+        break;
+    case 0x33:  // VSCRDEF
+        if (param_idx == 6) { tfa = p0; vsa = p1; }
+        break;
+    case 0x37:  // VSCRSADD
+        if (param_idx == 2) ssa = p0;
+        break;
+    default:
+        break;
+    }
+}
+
+void display_model_feed(int dc, const uint8_t *buf, size_t len) {
+    if (!gram) display_model_reset();
+    if (!gram || len == 0) return;
+    if (!dc) {
+        for (size_t i = 0; i < len; i++) model_cmd(buf[i]);
+        return;
+    }
+    mstats.data_transactions++;
+    mstats.data_bytes += len;
+    if (!ram_write) {
+        for (size_t i = 0; i < len; i++) model_param(buf[i]);
+        return;
+    }
+    size_t i = 0;
+    if (have_half) {
+        model_put((uint16_t)((half << 8) | buf[i++]));
+        have_half = false;
+    }
+    for (; i + 1 < len; i += 2) model_put((uint16_t)((buf[i] << 8) | buf[i + 1]));
+    if (i < len) {
+        half = buf[i];
+        have_half = true;
+    }
+}
+
+void display_model_stats(DisplayModelStats *out) {
+    *out = mstats;
+}
+
+void display_model_stats_reset(void) {
+    memset(&mstats, 0, sizeof(mstats));
+}
+
+// Hàng hiển thị -> hàng ghi. Với MADCTL MY=1 hàng ghi r nằm ở dòng bộ nhớ GRAM_H - 1 - r,
+// nên vùng cuộn theo tọa độ ghi là [GRAM_H - 1 - tfa - vsa + 1, GRAM_H - 1 - tfa]
+static int model_row(int r) {
+    if (vsa <= 0 || vsa >= GRAM_H || ssa == tfa) return r;
+    int top = GRAM_H - tfa - vsa;
+    if (r < top || r >= top + vsa) return r;
+    int v = ((ssa - tfa) % vsa + vsa) % vsa;
+    return top + ((r - top - v) % vsa + vsa) % vsa;
+}
+
+uint16_t display_model_pixel(int x, int y) {
+    if (!gram || x < 0 || y < 0 || x >= TFT_WIDTH || y >= TFT_HEIGHT) return 0;
+    return gram[model_row(y + OFFSET_Y) * GRAM_W + x + OFFSET_X];
+}
+
+// FNV-1a trên vùng nhìn thấy, dùng làm ảnh chuẩn khi so sánh màn hình
+uint32_t display_model_checksum(void) {
+    uint32_t h = 2166136261u;
+    for (int y = 0; y < TFT_HEIGHT; y++) {
+        for (int x = 0; x < TFT_WIDTH; x++) {
+            uint16_t c = display_model_pixel(x, y);
+            h = (h ^ (c & 0xFF)) * 16777619u;
+            h = (h ^ (c >> 8)) * 16777619u;
+        }
+    }
+    return h;
+}
+
+static void rgb888(uint16_t c, uint8_t out[3]) {
+    out[0] = (uint8_t)(((c >> 11) & 0x1F) * 255 / 31);
+    out[1] = (uint8_t)(((c >> 5) & 0x3F) * 255 / 63);
+    out[2] = (uint8_t)((c & 0x1F) * 255 / 31);
+}
+
+void display_model_write_ppm(FILE *f) {
+    fprintf(f, "P6\n%d %d\n255\n", TFT_WIDTH, TFT_HEIGHT);
+    for (int y = 0; y < TFT_HEIGHT; y++) {
+        for (int x = 0; x < TFT_WIDTH; x++) {
+            uint8_t px[3];
+            rgb888(display_model_pixel(x, y), px);
+            fwrite(px, 1, 3, f);
+        }
+    }
+}
+
+// Xuất ảnh qua console dạng hex theo dòng "PPM <y> <rgb...>"; tools/ppm_from_log.py ghép lại
+void display_model_dump(void) {
+    printf("PPM P6 %d %d %08lx\n", TFT_WIDTH, TFT_HEIGHT, (unsigned long)display_model_checksum());
+    for (int y = 0; y < TFT_HEIGHT; y++) {
+        printf("PPM %d ", y);
+        for (int x = 0; x < TFT_WIDTH; x++) {
+            uint8_t px[3];
+            rgb888(display_model_pixel(x, y), px);
+            printf("%02x%02x%02x", px[0], px[1], px[2]);
+        }
+        printf("\n");
+    }
+    printf("PPM END\n");
+}
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct {
+    uint32_t commands;
+    uint32_t data_transactions;
+    uint32_t data_bytes;
+    uint32_t windows;
+    uint32_t pixels;
+    uint32_t overflow_pixels;
+} DisplayModelStats;
+
+void display_model_reset(void);
+void display_model_feed(int dc, const uint8_t *buf, size_t len);
+void display_model_stats(DisplayModelStats *out);
+void display_model_stats_reset(void);
+uint16_t display_model_pixel(int x, int y);
+uint32_t display_model_checksum(void);
+void display_model_write_ppm(FILE *f);
+void display_model_dump(void);
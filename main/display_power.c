@@ -0,0 +1,88 @@
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "display.h"
+#include "display_power.h"
+#include "ldr_service.h"
+#include "ui_draw.h"
+#include "alarm_pipeline.h"
+
+#define TAG "DisplayPower"
+
+#define POWER_TASK_STACK_SIZE 2560
+#define POWER_TASK_PRIORITY   3
+#define POWER_TASK_CORE_ID    0
+#define POWER_PERIOD_MS       200
+#define LDR_DARK_ADC          300
+#define LDR_BRIGHT_ADC        3000
+#define BL_STEP_MIN           4
+
+static SemaphoreHandle_t power_mutex = NULL;
+static TickType_t last_activity = 0;
+static bool asleep = false;
+
+// Thao tác của người dùng hoặc báo thức; trả về true nếu lần gọi này đánh thức màn hình
+bool display_power_activity(void) {
+    if (!power_mutex) power_mutex = xSemaphoreCreateMutex();
+    xSemaphoreTake(power_mutex, portMAX_DELAY);
+    last_activity = xTaskGetTickCount();
+    bool woke = asleep;
+    if (asleep) {
+        asleep = false;
+        display_sleep(false);
+        ESP_LOGI(TAG, "Đánh thức màn hình");
+    }
+    xSemaphoreGive(power_mutex);
+    return woke;
+}
+
+// Độ sáng đèn nền theo cảm biến ánh sáng; ADC càng cao phòng càng sáng
+static uint8_t backlight_for(int adc) {
+    if (adc < LDR_DARK_ADC) adc = LDR_DARK_ADC;
+    if (adc > LDR_BRIGHT_ADC) adc = LDR_BRIGHT_ADC;
+    int span = 255 - CONFIG_DISPLAY_BACKLIGHT_MIN;
+    return (uint8_t)(CONFIG_DISPLAY_BACKLIGHT_MIN + span * (adc - LDR_DARK_ADC) / (LDR_BRIGHT_ADC - LDR_DARK_ADC));
+}
+
+static void display_power_task(void *pv) {
+    int avg = -1;       // trung bình trượt, nhân 8
+    int applied = 255;
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(POWER_PERIOD_MS));
+        // Vuốt tay qua cảm biến lúc báo thức là cử chỉ, không phải thay đổi ánh sáng
+        int adc = ldr.adc_handle ? ldr.last_value : -1;
+        if (adc >= 0 && !alarm_pipeline_active()) {
+            avg = avg < 0 ? adc * 8 : avg + adc - avg / 8;
+            int level = backlight_for(avg / 8);
+            if (level - applied >= BL_STEP_MIN || applied - level >= BL_STEP_MIN) {
+                applied = level;
+                display_set_backlight((uint8_t)level);
+            }
+        }
+#if CONFIG_DISPLAY_SLEEP_TIMEOUT_S > 0
+        xSemaphoreTake(power_mutex, portMAX_DELAY);
+        TickType_t idle = xTaskGetTickCount() - last_activity;
+        if (!asleep && ui_state == UI_IDLE && !alarm_pipeline_active() &&
+            idle >= pdMS_TO_TICKS(CONFIG_DISPLAY_SLEEP_TIMEOUT_S * 1000)) {
+            asleep = true;
+            display_sleep(true);
+            ESP_LOGI(TAG, "Màn hình ngủ sau %d s không thao tác", CONFIG_DISPLAY_SLEEP_TIMEOUT_S);
+        }
+        xSemaphoreGive(power_mutex);
+#endif
+    }
+}
+
+void display_power_start(void) {
+    if (!power_mutex) power_mutex = xSemaphoreCreateMutex();
+    last_activity = xTaskGetTickCount();
+    static TaskHandle_t handle = NULL;
+    if (handle) return;
+    if (xTaskCreatePinnedToCore(display_power_task, "disp_power", POWER_TASK_STACK_SIZE, NULL,
+                                POWER_TASK_PRIORITY, &handle, POWER_TASK_CORE_ID) != pdPASS) {
+        ESP_LOGE(TAG, "Không tạo được tác vụ quản lý đèn nền");
+    }
+}
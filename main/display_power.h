@@ -0,0 +1,5 @@
+#pragma once
+#include <stdbool.h>
+
+void display_power_start(void);
+bool display_power_activity(void);
@@ -1,4 +1,7 @@
 #pragma once
 #include <stdint.h>
 
-extern const uint8_t font5x7[][5];
+#define FONT_FIRST   0x20
+#define FONT_GLYPHS  95
+
+extern const uint8_t font5x7[FONT_GLYPHS][5];
@@ -0,0 +1,263 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "gfx.h"
+
+#define TAG "Gfx"
+
+// Lệnh vector 128 bit của ESP32-S3 (PIE); ee.vld/ee.vst.128 bỏ qua 4 bit thấp của địa chỉ nên chỉ dùng trên đoạn căn 16 byte
+#if (CONFIG_IDF_TARGET_ESP32S3 && CONFIG_DISPLAY_GFX_SIMD) || GFX_PIE_EMU
+#define GFX_PIE 1
+#else
+#define GFX_PIE 0
+#endif
+
+static inline bool aligned(const void *p, uintptr_t a) {
+    return ((uintptr_t)p & (a - 1)) == 0;
+}
+
+static void fill16_c(uint16_t *dst, uint16_t v, size_t n) {
+    if (n && !aligned(dst, 4)) { *dst++ = v; n--; }
+    uint32_t v2 = ((uint32_t)v << 16) | v;
+    uint32_t *d = (uint32_t *)dst;
+    size_t words = n >> 1;
+    for (; words >= 4; words -= 4, d += 4) { d[0] = v2; d[1] = v2; d[2] = v2; d[3] = v2; }
+    while (words--) *d++ = v2;
+    if (n & 1) *(uint16_t *)d = v;
+}
+
+static void swap16_c(uint16_t *dst, const uint16_t *src, size_t n) {
+    if (n && !aligned(dst, 4) && !aligned(src, 4)) { *dst++ = (uint16_t)((*src << 8) | (*src >> 8)); src++; n--; }
+    if (aligned(dst, 4) && aligned(src, 4)) {
+        uint32_t *d = (uint32_t *)dst;
+        const uint32_t *s = (const uint32_t *)src;
+        for (; n >= 2; n -= 2) {
+            uint32_t x = *s++;
+            *d++ = ((x & 0x00FF00FFu) << 8) | ((x >> 8) & 0x00FF00FFu);
+        }
+        dst = (uint16_t *)d;
+        src = (const uint16_t *)s;
+    }
+    while (n--) { *dst++ = (uint16_t)((*src << 8) | (*src >> 8)); src++; }
+}
+
+// Bảng 4 bit -> 4 điểm ảnh (8 byte) dựng theo cặp màu mỗi lần gọi
+static void expand1_c(uint16_t *dst, const uint8_t *bits, size_t n, uint16_t fg, uint16_t bg) {
+    if (!aligned(dst, 4)) {
+        for (size_t i = 0; i < n; i++) dst[i] = (bits[i >> 3] & (0x80 >> (i & 7))) ? fg : bg;
+        return;
+    }
+    uint32_t lut[16][2];
+    for (int k = 0; k < 16; k++) {
+        uint16_t p0 = (k & 8) ? fg : bg, p1 = (k & 4) ? fg : bg;
+        uint16_t p2 = (k & 2) ? fg : bg, p3 = (k & 1) ? fg : bg;
+        uint16_t px[4] = { p0, p1, p2, p3 };
+        memcpy(lut[k], px, 8);
+    }
+    uint32_t *d = (uint32_t *)dst;
+    size_t bytes = n >> 3;
+    for (size_t i = 0; i < bytes; i++) {
+        uint8_t b = bits[i];
+        d[0] = lut[b >> 4][0];
+        d[1] = lut[b >> 4][1];
+        d[2] = lut[b & 15][0];
+        d[3] = lut[b & 15][1];
+        d += 4;
+    }
+    for (size_t i = bytes << 3; i < n; i++) dst[i] = (bits[i >> 3] & (0x80 >> (i & 7))) ? fg : bg;
+}
+
+#if GFX_PIE
+static uint32_t pie_pattern[4] __attribute__((aligned(16)));
+
+#if GFX_PIE_EMU
+// Bản C cho host (main/host): chép 16 byte như ee.vld/ee.vst.128, kể cả việc bỏ qua 4 bit thấp của địa chỉ
+static void pie_store_blocks(void *dst, const void *pattern, size_t blocks) {
+    uint8_t *d = (uint8_t *)((uintptr_t)dst & ~(uintptr_t)15);
+    const uint8_t *p = (const uint8_t *)((uintptr_t)pattern & ~(uintptr_t)15);
+    for (; blocks; blocks--, d += 16) memcpy(d, p, 16);
+}
+
+static void pie_copy_blocks(void *dst, const void *src, size_t blocks) {
+    uint8_t *d = (uint8_t *)((uintptr_t)dst & ~(uintptr_t)15);
+    const uint8_t *p = (const uint8_t *)((uintptr_t)src & ~(uintptr_t)15);
+    for (; blocks; blocks--, d += 16, p += 16) memcpy(d, p, 16);
+}
+#else
+static void pie_store_blocks(void *dst, const void *pattern, size_t blocks) {
+    __asm__ volatile (
+        "ee.vld.128.ip q0, %1, 0\n"
+        "1:\n"
+        "ee.vst.128.ip q0, %0, 16\n"
+        "addi %2, %2, -1\n"
+        "bnez %2, 1b\n"
+        : "+r"(dst), "+r"(pattern), "+r"(blocks) : : "memory");
+}
+
+static void pie_copy_blocks(void *dst, const void *src, size_t blocks) {
+    __asm__ volatile (
+        "1:\n"
+        "ee.vld.128.ip q0, %1, 16\n"
+        "ee.vst.128.ip q0, %0, 16\n"
+        "addi %2, %2, -1\n"
+        "bnez %2, 1b\n"
+        : "+r"(dst), "+r"(src), "+r"(blocks) : : "memory");
+}
+#endif
+#endif
+
+void gfx_fill16(uint16_t *dst, uint16_t v, size_t n) {
+#if GFX_PIE
+    while (n && !aligned(dst, 16)) { *dst++ = v; n--; }
+    size_t blocks = n >> 3;
+    if (blocks) {
+        uint32_t v2 = ((uint32_t)v << 16) | v;
+        pie_pattern[0] = pie_pattern[1] = pie_pattern[2] = pie_pattern[3] = v2;
+        pie_store_blocks(dst, pie_pattern, blocks);
+        dst += blocks << 3;
+        n &= 7;
+    }
+#endif
+    fill16_c(dst, v, n);
+}
+
+void gfx_copy16(uint16_t *dst, const uint16_t *src, size_t n) {
+#if GFX_PIE
+    if ((((uintptr_t)dst ^ (uintptr_t)src) & 15) == 0) {
+        while (n && !aligned(dst, 16)) { *dst++ = *src++; n--; }
+        size_t blocks = n >> 3;
+        if (blocks) {
+            pie_copy_blocks(dst, src, blocks);
+            dst += blocks << 3;
+            src += blocks << 3;
+            n &= 7;
+        }
+    }
+#endif
+    memcpy(dst, src, n * 2);
+}
+
+void gfx_blit16(uint16_t *dst, int dst_stride, const uint16_t *src, int src_stride, int w, int h) {
+    if (w <= 0) return;
+    if (dst_stride == w && src_stride == w) {
+        gfx_copy16(dst, src, (size_t)w * h);
+        return;
+    }
+    for (int row = 0; row < h; row++) gfx_copy16(&dst[row * dst_stride], &src[row * src_stride], (size_t)w);
+}
+
+// Đổi thứ tự byte phải xáo trộn trong từng phần tử, dùng bản 32 bit cho mọi đích
+void gfx_swap16(uint16_t *dst, const uint16_t *src, size_t n) {
+    swap16_c(dst, src, n);
+}
+
+// n điểm ảnh từ ảnh 1 bit, bit 7 của mỗi byte là điểm ảnh đầu tiên. Không có bản PIE: bảng 8 điểm ảnh
+// mỗi byte phải dựng lại khi đổi cặp màu, mà dải tiêu đề và gợi ý đổi màu gần như mỗi lần vẽ
+void gfx_expand1(uint16_t *dst, const uint8_t *bits, size_t n, uint16_t fg, uint16_t bg) {
+    expand1_c(dst, bits, n, fg, bg);
+}
+
+// Mỗi byte là hai điểm ảnh 4 bit; lut đã có sẵn cặp RGB565 tương ứng
+void gfx_expand4(uint16_t *dst, const uint8_t *src, size_t n_bytes, const uint16_t lut[256][2]) {
+    if (aligned(dst, 4)) {
+        uint32_t *d = (uint32_t *)dst;
+        for (size_t i = 0; i < n_bytes; i++) memcpy(&d[i], lut[src[i]], 4);
+        return;
+    }
+    for (size_t i = 0; i < n_bytes; i++) {
+        dst[2 * i]     = lut[src[i]][0];
+        dst[2 * i + 1] = lut[src[i]][1];
+    }
+}
+
+#if CONFIG_DISPLAY_GFX_SELFTEST
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+
+#define ST_PX     2048
+#define ST_ROUNDS 200
+
+static uint32_t st_rand = 12345;
+
+static uint32_t st_next(void) {
+    st_rand = st_rand * 1103515245u + 12345u;
+    return st_rand >> 8;
+}
+
+static void ref_fill(uint16_t *d, uint16_t v, size_t n) { for (size_t i = 0; i < n; i++) d[i] = v; }
+static void ref_copy(uint16_t *d, const uint16_t *s, size_t n) { for (size_t i = 0; i < n; i++) d[i] = s[i]; }
+static void ref_swap(uint16_t *d, const uint16_t *s, size_t n) { for (size_t i = 0; i < n; i++) d[i] = (uint16_t)((s[i] << 8) | (s[i] >> 8)); }
+static void ref_expand1(uint16_t *d, const uint8_t *b, size_t n, uint16_t fg, uint16_t bg) {
+    for (size_t i = 0; i < n; i++) d[i] = (b[i >> 3] & (0x80 >> (i & 7))) ? fg : bg;
+}
+static void ref_expand4(uint16_t *d, const uint8_t *s, size_t n, const uint16_t lut[256][2]) {
+    for (size_t i = 0; i < n; i++) { d[2 * i] = lut[s[i]][0]; d[2 * i + 1] = lut[s[i]][1]; }
+}
+
+// So từng nhân với vòng lặp từng điểm ảnh trên độ dài và độ lệch căn ngẫu nhiên, rồi đo chu kỳ trên một dòng đầy
+int gfx_selftest_run(void) {
+    uint16_t *a = heap_caps_aligned_alloc(16, (ST_PX + 16) * 2, MALLOC_CAP_INTERNAL);
+    uint16_t *b = heap_caps_aligned_alloc(16, (ST_PX + 16) * 2, MALLOC_CAP_INTERNAL);
+    uint16_t *src = heap_caps_aligned_alloc(16, (ST_PX + 16) * 2, MALLOC_CAP_INTERNAL);
+    static uint16_t lut[256][2];
+    if (!a || !b || !src) {
+        ESP_LOGE(TAG, "Không đủ bộ nhớ cho tự kiểm tra");
+        heap_caps_free(a); heap_caps_free(b); heap_caps_free(src);
+        return -1;
+    }
+    for (int i = 0; i < ST_PX + 16; i++) src[i] = (uint16_t)st_next();
+    for (int i = 0; i < 256; i++) { lut[i][0] = (uint16_t)st_next(); lut[i][1] = (uint16_t)st_next(); }
+    const uint8_t *bytes = (const uint8_t *)src;
+    int bad = 0;
+    for (int r = 0; r < ST_ROUNDS; r++) {
+        size_t n = st_next() % ST_PX;
+        int od = st_next() % 8, os = st_next() % 8;
+        uint16_t fg = (uint16_t)st_next(), bg = (uint16_t)st_next();
+        memset(a, 0xA5, (ST_PX + 16) * 2); memset(b, 0xA5, (ST_PX + 16) * 2);
+        gfx_fill16(a + od, fg, n); ref_fill(b + od, fg, n);
+        bad += memcmp(a, b, (ST_PX + 16) * 2) != 0;
+        gfx_copy16(a + od, src + os, n); ref_copy(b + od, src + os, n);
+        bad += memcmp(a, b, (ST_PX + 16) * 2) != 0;
+        gfx_swap16(a + od, src + os, n); ref_swap(b + od, src + os, n);
+        bad += memcmp(a, b, (ST_PX + 16) * 2) != 0;
+        gfx_expand1(a + od, bytes + os, n, fg, bg); ref_expand1(b + od, bytes + os, n, fg, bg);
+        bad += memcmp(a, b, (ST_PX + 16) * 2) != 0;
+        gfx_expand4(a + od, bytes + os, n / 2, lut); ref_expand4(b + od, bytes + os, n / 2, lut);
+        bad += memcmp(a, b, (ST_PX + 16) * 2) != 0;
+    }
+    ESP_LOGI(TAG, "Tự kiểm tra %s: %d/%d sai khác", GFX_PIE ? "PIE" : "C", bad, ST_ROUNDS * 5);
+
+    const size_t n = ST_PX;
+    uint32_t t[11];
+    t[0] = esp_cpu_get_cycle_count();
+    ref_fill(b, 0x1234, n);                 t[1] = esp_cpu_get_cycle_count();
+    gfx_fill16(a, 0x1234, n);               t[2] = esp_cpu_get_cycle_count();
+    ref_copy(b, src, n);                    t[3] = esp_cpu_get_cycle_count();
+    gfx_copy16(a, src, n);                  t[4] = esp_cpu_get_cycle_count();
+    ref_expand1(b, bytes, n, 0xFFFF, 0);    t[5] = esp_cpu_get_cycle_count();
+    gfx_expand1(a, bytes, n, 0xFFFF, 0);    t[6] = esp_cpu_get_cycle_count();
+    ref_expand4(b, bytes, n / 2, lut);      t[7] = esp_cpu_get_cycle_count();
+    gfx_expand4(a, bytes, n / 2, lut);      t[8] = esp_cpu_get_cycle_count();
+    ref_swap(b, src, n);                    t[9] = esp_cpu_get_cycle_count();
+    gfx_swap16(a, src, n);                  t[10] = esp_cpu_get_cycle_count();
+    ESP_LOGI(TAG, "%u px, chu kỳ tham chiếu/nhân: fill %lu/%lu copy %lu/%lu expand1 %lu/%lu expand4 %lu/%lu swap %lu/%lu",
+             (unsigned)n,
+             (unsigned long)(t[1] - t[0]), (unsigned long)(t[2] - t[1]),
+             (unsigned long)(t[3] - t[2]), (unsigned long)(t[4] - t[3]),
+             (unsigned long)(t[5] - t[4]), (unsigned long)(t[6] - t[5]),
+             (unsigned long)(t[7] - t[6]), (unsigned long)(t[8] - t[7]),
+             (unsigned long)(t[9] - t[8]), (unsigned long)(t[10] - t[9]));
+    heap_caps_free(a); heap_caps_free(b); heap_caps_free(src);
+    return bad;
+}
+
+#else
+
+int gfx_selftest_run(void) {
+    ESP_LOGW(TAG, "CONFIG_DISPLAY_GFX_SELFTEST chưa bật");
+    return 0;
+}
+
+#endif
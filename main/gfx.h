@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Nhân xử lý điểm ảnh RGB565 cho bộ đệm dòng và framebuffer; điểm ảnh giữ nguyên thứ tự byte đã có
+void gfx_fill16(uint16_t *dst, uint16_t v, size_t n);
+void gfx_copy16(uint16_t *dst, const uint16_t *src, size_t n);
+void gfx_blit16(uint16_t *dst, int dst_stride, const uint16_t *src, int src_stride, int w, int h);
+void gfx_swap16(uint16_t *dst, const uint16_t *src, size_t n);
+void gfx_expand1(uint16_t *dst, const uint8_t *bits, size_t n, uint16_t fg, uint16_t bg);
+void gfx_expand4(uint16_t *dst, const uint8_t *src, size_t n_bytes, const uint16_t lut[256][2]);
+// Số lần sai khác so với vòng lặp tham chiếu, -1 nếu thiếu bộ nhớ
+int gfx_selftest_run(void);
@@ -0,0 +1,285 @@
+#include "glyph.h"
+#include <string.h>
+#include "sdkconfig.h"
+#include "display.h"
+#include "font.h"
+
+#ifndef CONFIG_DISPLAY_GLYPH_CACHE
+#define CONFIG_DISPLAY_GLYPH_CACHE 32
+#endif
+#ifndef CONFIG_DISPLAY_STRIP_CACHE
+#define CONFIG_DISPLAY_STRIP_CACHE 12
+#endif
+#define STRIP_TEXT_MAX 64
+
+enum { VN_BREVE = 1, VN_CIRCUMFLEX, VN_HORN, VN_STROKE };
+enum { VN_GRAVE = 1, VN_ACUTE, VN_HOOK, VN_TILDE, VN_DOT };
+
+typedef struct {
+    uint16_t cp;
+    char base;
+    uint8_t mod;
+    uint8_t tone;
+} VnGlyph;
+
+// Sắp theo mã để tìm nhị phân
+static const VnGlyph vn_glyphs[] = {
+    {0x00C0, 'A', 0, VN_GRAVE}, {0x00C1, 'A', 0, VN_ACUTE}, {0x00C2, 'A', VN_CIRCUMFLEX, 0},
+    {0x00C3, 'A', 0, VN_TILDE}, {0x00C8, 'E', 0, VN_GRAVE}, {0x00C9, 'E', 0, VN_ACUTE},
+    {0x00CA, 'E', VN_CIRCUMFLEX, 0}, {0x00CC, 'I', 0, VN_GRAVE}, {0x00CD, 'I', 0, VN_ACUTE},
+    {0x00D2, 'O', 0, VN_GRAVE}, {0x00D3, 'O', 0, VN_ACUTE}, {0x00D4, 'O', VN_CIRCUMFLEX, 0},
+    {0x00D5, 'O', 0, VN_TILDE}, {0x00D9, 'U', 0, VN_GRAVE}, {0x00DA, 'U', 0, VN_ACUTE},
+    {0x00DD, 'Y', 0, VN_ACUTE}, {0x00E0, 'a', 0, VN_GRAVE}, {0x00E1, 'a', 0, VN_ACUTE},
+    {0x00E2, 'a', VN_CIRCUMFLEX, 0}, {0x00E3, 'a', 0, VN_TILDE}, {0x00E8, 'e', 0, VN_GRAVE},
+    {0x00E9, 'e', 0, VN_ACUTE}, {0x00EA, 'e', VN_CIRCUMFLEX, 0}, {0x00EC, 'i', 0, VN_GRAVE},
+    {0x00ED, 'i', 0, VN_ACUTE}, {0x00F2, 'o', 0, VN_GRAVE}, {0x00F3, 'o', 0, VN_ACUTE},
+    {0x00F4, 'o', VN_CIRCUMFLEX, 0}, {0x00F5, 'o', 0, VN_TILDE}, {0x00F9, 'u', 0, VN_GRAVE},
+    {0x00FA, 'u', 0, VN_ACUTE}, {0x00FD, 'y', 0, VN_ACUTE}, {0x0102, 'A', VN_BREVE, 0},
+    {0x0103, 'a', VN_BREVE, 0}, {0x0110, 'D', VN_STROKE, 0}, {0x0111, 'd', VN_STROKE, 0},
+    {0x0128, 'I', 0, VN_TILDE}, {0x0129, 'i', 0, VN_TILDE}, {0x0168, 'U', 0, VN_TILDE},
+    {0x0169, 'u', 0, VN_TILDE}, {0x01A0, 'O', VN_HORN, 0}, {0x01A1, 'o', VN_HORN, 0},
+    {0x01AF, 'U', VN_HORN, 0}, {0x01B0, 'u', VN_HORN, 0}, {0x1EA0, 'A', 0, VN_DOT},
+    {0x1EA1, 'a', 0, VN_DOT}, {0x1EA2, 'A', 0, VN_HOOK}, {0x1EA3, 'a', 0, VN_HOOK},
+    {0x1EA4, 'A', VN_CIRCUMFLEX, VN_ACUTE}, {0x1EA5, 'a', VN_CIRCUMFLEX, VN_ACUTE}, {0x1EA6, 'A', VN_CIRCUMFLEX, VN_GRAVE},
+    {0x1EA7, 'a', VN_CIRCUMFLEX, VN_GRAVE}, {0x1EA8, 'A', VN_CIRCUMFLEX, VN_HOOK}, {0x1EA9, 'a', VN_CIRCUMFLEX, VN_HOOK},
+    {0x1EAA, 'A', VN_CIRCUMFLEX, VN_TILDE}, {0x1EAB, 'a', VN_CIRCUMFLEX, VN_TILDE}, {0x1EAC, 'A', VN_CIRCUMFLEX, VN_DOT},
+    {0x1EAD, 'a', VN_CIRCUMFLEX, VN_DOT}, {0x1EAE, 'A', VN_BREVE, VN_ACUTE}, {0x1EAF, 'a', VN_BREVE, VN_ACUTE},
+    {0x1EB0, 'A', VN_BREVE, VN_GRAVE}, {0x1EB1, 'a', VN_BREVE, VN_GRAVE}, {0x1EB2, 'A', VN_BREVE, VN_HOOK},
+    {0x1EB3, 'a', VN_BREVE, VN_HOOK}, {0x1EB4, 'A', VN_BREVE, VN_TILDE}, {0x1EB5, 'a', VN_BREVE, VN_TILDE},
+    {0x1EB6, 'A', VN_BREVE, VN_DOT}, {0x1EB7, 'a', VN_BREVE, VN_DOT}, {0x1EB8, 'E', 0, VN_DOT},
+    {0x1EB9, 'e', 0, VN_DOT}, {0x1EBA, 'E', 0, VN_HOOK}, {0x1EBB, 'e', 0, VN_HOOK},
+    {0x1EBC, 'E', 0, VN_TILDE}, {0x1EBD, 'e', 0, VN_TILDE}, {0x1EBE, 'E', VN_CIRCUMFLEX, VN_ACUTE},
+    {0x1EBF, 'e', VN_CIRCUMFLEX, VN_ACUTE}, {0x1EC0, 'E', VN_CIRCUMFLEX, VN_GRAVE}, {0x1EC1, 'e', VN_CIRCUMFLEX, VN_GRAVE},
+    {0x1EC2, 'E', VN_CIRCUMFLEX, VN_HOOK}, {0x1EC3, 'e', VN_CIRCUMFLEX, VN_HOOK}, {0x1EC4, 'E', VN_CIRCUMFLEX, VN_TILDE},
+    {0x1EC5, 'e', VN_CIRCUMFLEX, VN_TILDE}, {0x1EC6, 'E', VN_CIRCUMFLEX, VN_DOT}, {0x1EC7, 'e', VN_CIRCUMFLEX, VN_DOT},
+    {0x1EC8, 'I', 0, VN_HOOK}, {0x1EC9, 'i', 0, VN_HOOK}, {0x1ECA, 'I', 0, VN_DOT},
+    {0x1ECB, 'i', 0, VN_DOT}, {0x1ECC, 'O', 0, VN_DOT}, {0x1ECD, 'o', 0, VN_DOT},
+    {0x1ECE, 'O', 0, VN_HOOK}, {0x1ECF, 'o', 0, VN_HOOK}, {0x1ED0, 'O', VN_CIRCUMFLEX, VN_ACUTE},
+    {0x1ED1, 'o', VN_CIRCUMFLEX, VN_ACUTE}, {0x1ED2, 'O', VN_CIRCUMFLEX, VN_GRAVE}, {0x1ED3, 'o', VN_CIRCUMFLEX, VN_GRAVE},
+    {0x1ED4, 'O', VN_CIRCUMFLEX, VN_HOOK}, {0x1ED5, 'o', VN_CIRCUMFLEX, VN_HOOK}, {0x1ED6, 'O', VN_CIRCUMFLEX, VN_TILDE},
+    {0x1ED7, 'o', VN_CIRCUMFLEX, VN_TILDE}, {0x1ED8, 'O', VN_CIRCUMFLEX, VN_DOT}, {0x1ED9, 'o', VN_CIRCUMFLEX, VN_DOT},
+    {0x1EDA, 'O', VN_HORN, VN_ACUTE}, {0x1EDB, 'o', VN_HORN, VN_ACUTE}, {0x1EDC, 'O', VN_HORN, VN_GRAVE},
+    {0x1EDD, 'o', VN_HORN, VN_GRAVE}, {0x1EDE, 'O', VN_HORN, VN_HOOK}, {0x1EDF, 'o', VN_HORN, VN_HOOK},
+    {0x1EE0, 'O', VN_HORN, VN_TILDE}, {0x1EE1, 'o', VN_HORN, VN_TILDE}, {0x1EE2, 'O', VN_HORN, VN_DOT},
+    {0x1EE3, 'o', VN_HORN, VN_DOT}, {0x1EE4, 'U', 0, VN_DOT}, {0x1EE5, 'u', 0, VN_DOT},
+    {0x1EE6, 'U', 0, VN_HOOK}, {0x1EE7, 'u', 0, VN_HOOK}, {0x1EE8, 'U', VN_HORN, VN_ACUTE},
+    {0x1EE9, 'u', VN_HORN, VN_ACUTE}, {0x1EEA, 'U', VN_HORN, VN_GRAVE}, {0x1EEB, 'u', VN_HORN, VN_GRAVE},
+    {0x1EEC, 'U', VN_HORN, VN_HOOK}, {0x1EED, 'u', VN_HORN, VN_HOOK}, {0x1EEE, 'U', VN_HORN, VN_TILDE},
+    {0x1EEF, 'u', VN_HORN, VN_TILDE}, {0x1EF0, 'U', VN_HORN, VN_DOT}, {0x1EF1, 'u', VN_HORN, VN_DOT},
+    {0x1EF2, 'Y', 0, VN_GRAVE}, {0x1EF3, 'y', 0, VN_GRAVE}, {0x1EF4, 'Y', 0, VN_DOT},
+    {0x1EF5, 'y', 0, VN_DOT}, {0x1EF6, 'Y', 0, VN_HOOK}, {0x1EF7, 'y', 0, VN_HOOK},
+    {0x1EF8, 'Y', 0, VN_TILDE}, {0x1EF9, 'y', 0, VN_TILDE},
+};
+
+// Dấu phụ đặt giữa ô; khi đi cùng dấu thanh thì thu về cột 0-2, dấu thanh sang cột 3-4
+static const uint8_t mod_mid[4][5] = {
+    {0},
+    {0x00, 0x01, 0x02, 0x01, 0x00},     // breve
+    {0x00, 0x02, 0x01, 0x02, 0x00},     // circumflex
+    {0x00, 0x00, 0x00, 0x00, 0x02},     // horn
+};
+static const uint8_t mod_left[3][3] = {
+    {0},
+    {0x01, 0x02, 0x01},
+    {0x02, 0x01, 0x02},
+};
+static const uint8_t tone_mid[6][5] = {
+    {0},
+    {0x00, 0x01, 0x02, 0x00, 0x00},     // huyền
+    {0x00, 0x00, 0x02, 0x01, 0x00},     // sắc
+    {0x00, 0x01, 0x03, 0x00, 0x00},     // hỏi
+    {0x02, 0x01, 0x02, 0x01, 0x00},     // ngã
+    {0x00, 0x00, 0x80, 0x00, 0x00},     // nặng
+};
+static const uint8_t tone_right[5][2] = {
+    {0},
+    {0x01, 0x02},
+    {0x02, 0x01},
+    {0x01, 0x03},
+    {0x01, 0x01},
+};
+
+uint32_t utf8_next(const char **s) {
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t c = p[0];
+    if (c == 0) return 0;
+    int len;
+    uint32_t min;
+    if (c < 0x80) { *s += 1; return c; }
+    else if ((c & 0xE0) == 0xC0) { len = 2; c &= 0x1F; min = 0x80; }
+    else if ((c & 0xF0) == 0xE0) { len = 3; c &= 0x0F; min = 0x800; }
+    else if ((c & 0xF8) == 0xF0) { len = 4; c &= 0x07; min = 0x10000; }
+    else { *s += 1; return GLYPH_INVALID; }
+    for (int i = 1; i < len; i++) {
+        if ((p[i] & 0xC0) != 0x80) { *s += 1; return GLYPH_INVALID; }
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    *s += len;
+    if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) return GLYPH_INVALID;
+    return c;
+}
+
+// Số glyph trong n byte đầu của s
+size_t utf8_glyphs(const char *s, size_t n) {
+    const char *end = s + n;
+    size_t count = 0;
+    while (s < end && utf8_next(&s)) count++;
+    return count;
+}
+
+// Số byte của tối đa max_glyphs glyph đầu tiên, không cắt giữa một ký tự
+size_t utf8_prefix(const char *s, size_t max_glyphs) {
+    const char *p = s;
+    while (max_glyphs-- && *p) utf8_next(&p);
+    return (size_t)(p - s);
+}
+
+static const VnGlyph *vn_find(uint32_t cp) {
+    int lo = 0, hi = (int)(sizeof(vn_glyphs) / sizeof(vn_glyphs[0])) - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (vn_glyphs[mid].cp == cp) return &vn_glyphs[mid];
+        if (vn_glyphs[mid].cp < cp) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+// Chữ hoa chiếm đủ 7 hàng nên phải nén vào hàng 2-6 để chừa chỗ cho dấu phía trên
+static uint8_t squash(uint8_t b) {
+    uint8_t r = ((b | (b >> 1)) & 0x01)
+              | ((b >> 2) & 0x01) << 1
+              | ((b >> 3) & 0x01) << 2
+              | ((b >> 4) & 0x01) << 3
+              | (((b >> 5) | (b >> 6)) & 0x01) << 4;
+    return r << 2;
+}
+
+static void compose(const VnGlyph *v, uint8_t out[5]) {
+    memcpy(out, font5x7[v->base - FONT_FIRST], 5);
+    bool upper = v->base >= 'A' && v->base <= 'Z';
+    if (v->mod == VN_STROKE) {
+        if (upper) out[1] |= 0x08;
+        else { out[2] |= 0x02; out[3] |= 0x02; }
+        return;
+    }
+    bool above = v->mod != 0 || (v->tone && v->tone != VN_DOT);
+    if (above) {
+        for (int i = 0; i < 5; i++) out[i] = upper ? squash(out[i]) : (out[i] & ~0x03);
+    }
+    bool split = (v->mod == VN_BREVE || v->mod == VN_CIRCUMFLEX) && v->tone && v->tone != VN_DOT;
+    if (split) {
+        for (int i = 0; i < 3; i++) out[i] |= mod_left[v->mod][i];
+        out[3] |= tone_right[v->tone][0];
+        out[4] |= tone_right[v->tone][1];
+        return;
+    }
+    for (int i = 0; i < 5; i++) out[i] |= mod_mid[v->mod][i] | tone_mid[v->tone][i];
+}
+
+// 5 cột của glyph, bit 0 là hàng trên; trả về false nếu phải thay bằng '?'
+bool glyph_bits(uint32_t cp, uint8_t out[5]) {
+    if (cp >= FONT_FIRST && cp < FONT_FIRST + FONT_GLYPHS) {
+        memcpy(out, font5x7[cp - FONT_FIRST], 5);
+        return true;
+    }
+    const VnGlyph *v = cp <= 0xFFFF ? vn_find(cp) : NULL;
+    if (v) {
+        compose(v, out);
+        return true;
+    }
+    memcpy(out, font5x7['?' - FONT_FIRST], 5);
+    return false;
+}
+
+typedef struct {
+    uint32_t cp;
+    uint16_t fg, bg;
+    uint32_t used;
+    uint16_t px[FONT_W * GLYPH_H];
+} GlyphSlot;
+
+// Chỉ tác vụ hiển thị dùng bộ đệm này nên không cần khóa
+static GlyphSlot cache[CONFIG_DISPLAY_GLYPH_CACHE];
+static uint32_t cache_tick, cache_hits, cache_misses;
+
+// Glyph FONT_W x GLYPH_H đã tô màu, byte đã đảo sẵn cho SPI, hàng liền nhau
+const uint16_t *glyph_rgb565(uint32_t cp, uint16_t fg, uint16_t bg) {
+    uint16_t f = (uint16_t)((fg << 8) | (fg >> 8));
+    uint16_t b = (uint16_t)((bg << 8) | (bg >> 8));
+    GlyphSlot *victim = &cache[0];
+    cache_tick++;
+    for (int i = 0; i < CONFIG_DISPLAY_GLYPH_CACHE; i++) {
+        GlyphSlot *s = &cache[i];
+        if (s->used && s->cp == cp && s->fg == f && s->bg == b) {
+            s->used = cache_tick;
+            cache_hits++;
+            return s->px;
+        }
+        if (s->used < victim->used) victim = s;
+    }
+    cache_misses++;
+    uint8_t bits[5];
+    glyph_bits(cp, bits);
+    for (int row = 0; row < GLYPH_H; row++) {
+        for (int col = 0; col < FONT_W; col++) {
+            bool on = col < 5 && (bits[col] & (1 << row));
+            victim->px[row * FONT_W + col] = on ? f : b;
+        }
+    }
+    victim->cp = cp;
+    victim->fg = f;
+    victim->bg = b;
+    victim->used = cache_tick;
+    return victim->px;
+}
+
+void glyph_cache_stats(uint32_t *hits, uint32_t *misses) {
+    if (hits) *hits = cache_hits;
+    if (misses) *misses = cache_misses;
+}
+
+typedef struct {
+    char text[STRIP_TEXT_MAX];
+    uint32_t used;
+    uint8_t bits[STRIP_STRIDE * STRIP_H];
+} StripSlot;
+
+static StripSlot strips[CONFIG_DISPLAY_STRIP_CACHE];
+static uint32_t strip_tick, strip_hits, strip_misses;
+
+// Ảnh 1 bit của cả dòng (hàng liền nhau, bit 7 là cột trái), màu chỉ áp khi đẩy ra màn hình
+const uint8_t *strip_bits(const char *text) {
+    StripSlot *victim = &strips[0];
+    strip_tick++;
+    for (int i = 0; i < CONFIG_DISPLAY_STRIP_CACHE; i++) {
+        StripSlot *s = &strips[i];
+        if (s->used && strncmp(s->text, text, STRIP_TEXT_MAX) == 0) {
+            s->used = strip_tick;
+            strip_hits++;
+            return s->bits;
+        }
+        if (s->used < victim->used) victim = s;
+    }
+    strip_misses++;
+    memset(victim->bits, 0, sizeof(victim->bits));
+    strncpy(victim->text, text, STRIP_TEXT_MAX);
+    const char *p = text;
+    uint32_t cp;
+    for (int x = STRIP_TX; x < TFT_WIDTH && (cp = utf8_next(&p)) != 0; x += FONT_W) {
+        uint8_t g[5];
+        glyph_bits(cp, g);
+        for (int col = 0; col < 5 && x + col < TFT_WIDTH; col++) {
+            for (int row = 0; row < GLYPH_H; row++) {
+                if (g[col] & (1 << row)) victim->bits[row * STRIP_STRIDE + (x + col) / 8] |= 0x80 >> ((x + col) % 8);
+            }
+        }
+    }
+    victim->used = strip_tick;
+    return victim->bits;
+}
+
+void strip_cache_stats(uint32_t *hits, uint32_t *misses) {
+    if (hits) *hits = strip_hits;
+    if (misses) *misses = strip_misses;
+}
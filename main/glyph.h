@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Ô chữ cao 8 hàng: hàng 0-6 là glyph 5x7, hàng 7 dành cho dấu nặng
+#define GLYPH_H        8
+#define GLYPH_INVALID  0xFFFD
+
+uint32_t utf8_next(const char **s);
+size_t utf8_glyphs(const char *s, size_t n);
+size_t utf8_prefix(const char *s, size_t max_glyphs);
+
+bool glyph_bits(uint32_t cp, uint8_t out[5]);
+const uint16_t *glyph_rgb565(uint32_t cp, uint16_t fg, uint16_t bg);
+void glyph_cache_stats(uint32_t *hits, uint32_t *misses);
+const uint8_t *strip_bits(const char *text);
+void strip_cache_stats(uint32_t *hits, uint32_t *misses);
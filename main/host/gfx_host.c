@@ -0,0 +1,6 @@
+// Chạy gfx_selftest_run() trên máy tính: gfx_c dùng nhân C, gfx_pie dùng bản mô phỏng lệnh PIE
+#include "gfx.h"
+
+int main(void) {
+    return gfx_selftest_run() == 0 ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+// Trên host "chu kỳ" là nano giây
+static inline uint32_t esp_cpu_get_cycle_count(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)(t.tv_sec * 1000000000ull + t.tv_nsec);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdlib.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_INTERNAL 0
+#define MALLOC_CAP_DMA      0
+
+static inline void *heap_caps_aligned_alloc(size_t align, size_t n, uint32_t caps) {
+    (void)caps;
+    return aligned_alloc(align, (n + align - 1) / align * align);
+}
+
+static inline void heap_caps_free(void *p) {
+    free(p);
+}
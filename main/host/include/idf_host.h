@@ -0,0 +1,65 @@
+#pragma once
+// Kiểu và khai báo IDF tối thiểu để dịch các tệp lập lịch trên máy tính; chỉ có những gì
+// các header trong main/ cần, phần thân hàm nằm ở sched_host.c
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+#define ESP_ERR_NVS_NOT_FOUND         0x1102
+#define ESP_ERR_NVS_NO_FREE_PAGES     0x110d
+#define ESP_ERR_NVS_NEW_VERSION_FOUND 0x1110
+#define ESP_ERROR_CHECK(x) do { esp_err_t err_ = (x); (void)err_; } while (0)
+const char *esp_err_to_name(esp_err_t err);
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void *EventGroupHandle_t;
+typedef void (*TaskFunction_t)(void *);
+#define pdTRUE        1
+#define pdFALSE       0
+#define pdPASS        1
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *out, BaseType_t core);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s);
+
+int64_t esp_timer_get_time(void);
+
+typedef uint32_t nvs_handle_t;
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+esp_err_t nvs_open(const char *ns, nvs_open_mode_t mode, nvs_handle_t *out);
+esp_err_t nvs_set_str(nvs_handle_t h, const char *key, const char *val);
+esp_err_t nvs_get_str(nvs_handle_t h, const char *key, char *out, size_t *len);
+esp_err_t nvs_get_blob(nvs_handle_t h, const char *key, void *out, size_t *len);
+esp_err_t nvs_set_blob(nvs_handle_t h, const char *key, const void *val, size_t len);
+esp_err_t nvs_get_i32(nvs_handle_t h, const char *key, int32_t *out);
+esp_err_t nvs_set_i32(nvs_handle_t h, const char *key, int32_t val);
+esp_err_t nvs_commit(nvs_handle_t h);
+void nvs_close(nvs_handle_t h);
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
+
+typedef int gpio_num_t;
+typedef void *adc_oneshot_unit_handle_t;
+typedef int adc_channel_t;
+
+typedef struct cJSON cJSON;
+cJSON *cJSON_CreateObject(void);
+cJSON *cJSON_AddNumberToObject(cJSON *obj, const char *name, double num);
+cJSON *cJSON_AddStringToObject(cJSON *obj, const char *name, const char *str);
+char *cJSON_PrintUnformatted(const cJSON *item);
+void cJSON_Delete(cJSON *item);
@@ -0,0 +1,18 @@
+#pragma once
+// Cấu hình cho bản dựng host, không có CONFIG_IDF_TARGET_* nên chỉ chạy được nhân C hoặc bản mô phỏng PIE
+#define CONFIG_DISPLAY_GFX_SELFTEST 1
+
+// Mô phỏng lập lịch: giá trị mặc định như Kconfig, đổi bằng make sim SIM_ALARM_SECS=...
+#define CONFIG_REMINDER_SCHED_SIM 1
+#ifndef CONFIG_REMINDER_SIM_COUNT
+#define CONFIG_REMINDER_SIM_COUNT 1000
+#endif
+#ifndef CONFIG_REMINDER_SIM_DAYS
+#define CONFIG_REMINDER_SIM_DAYS 365
+#endif
+#ifndef CONFIG_REMINDER_SIM_ALARM_SECS
+#define CONFIG_REMINDER_SIM_ALARM_SECS 180
+#endif
+#define CONFIG_REMINDER_TZ "ICT-7"
+#define CONFIG_REMINDER_SNOOZE_SECS 300
+#define CONFIG_REMINDER_SNOOZE_MAX_REPEATS 3
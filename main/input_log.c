@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "display.h"
+#include "ui_draw.h"
+#include "ui_fsm.h"
+#include "civil_time.h"
+#include "alarm_pipeline.h"
+#include "input_log.h"
+
+#if CONFIG_BUTTON_INPUT_LOG
+#include "cJSON.h"
+#include "mqtt.h"
+#if CONFIG_DISPLAY_MODEL
+#include "display_model.h"
+#endif
+
+#define TAG "InputLog"
+
+#define LOG_BYTES        (CONFIG_BUTTON_INPUT_LOG_EVENTS * INPUT_LOG_REC_BYTES)
+#define REPLAY_STACK     6144
+#define REPLAY_PRIORITY  4
+#define REPLAY_YEAR      2025
+#define REPLAY_MONTH     6
+#define REPLAY_DAY       16
+#define REPLAY_HOUR      9
+
+static const char btn_names[4][7] = { "OK", "BACK", "NEXT", "CANCEL" };
+
+static SemaphoreHandle_t log_mutex = NULL;
+static uint8_t log_buf[LOG_BYTES];
+static size_t log_len = 0;
+static bool recording = false;
+static int64_t last_us = 0;
+static volatile bool replay_busy = false;
+
+typedef struct {
+    bool timed;
+    size_t n;
+    uint8_t data[];
+} ReplayJob;
+
+static void log_lock(void) {
+    if (!log_mutex) log_mutex = xSemaphoreCreateMutex();
+    xSemaphoreTake(log_mutex, portMAX_DELAY);
+}
+
+static void log_unlock(void) {
+    xSemaphoreGive(log_mutex);
+}
+
+void input_log_start(void) {
+    log_lock();
+    log_len = 0;
+    last_us = esp_timer_get_time();
+    recording = true;
+    log_unlock();
+    ESP_LOGI(TAG, "Bắt đầu ghi phím (tối đa %d sự kiện)", CONFIG_BUTTON_INPUT_LOG_EVENTS);
+}
+
+void input_log_stop(void) {
+    log_lock();
+    recording = false;
+    log_unlock();
+    ESP_LOGI(TAG, "Dừng ghi phím: %u sự kiện", (unsigned)(log_len / INPUT_LOG_REC_BYTES));
+}
+
+void input_log_record(const BtnEdges *e) {
+    if (!recording) return;
+    int btn = e->ok_edge ? INPUT_BTN_OK : e->back_edge ? INPUT_BTN_BACK : e->next_edge ? INPUT_BTN_NEXT : INPUT_BTN_CANCEL;
+    int64_t now = esp_timer_get_time();
+    log_lock();
+    if (recording && log_len + INPUT_LOG_REC_BYTES <= LOG_BYTES) {
+        int64_t dt = (now - last_us) / 1000;
+        if (dt > UINT16_MAX) dt = UINT16_MAX;
+        log_buf[log_len++] = (uint8_t)dt;
+        log_buf[log_len++] = (uint8_t)(dt >> 8);
+        log_buf[log_len++] = (uint8_t)(btn | ((e->repeat < 63 ? e->repeat : 63) << 2));
+        last_us = now;
+    }
+    log_unlock();
+}
+
+size_t input_log_copy(uint8_t *out, size_t max) {
+    log_lock();
+    size_t n = log_len < max ? log_len : max;
+    memcpy(out, log_buf, n);
+    log_unlock();
+    return n - n % INPUT_LOG_REC_BYTES;
+}
+
+size_t input_log_from_hex(const char *hex, uint8_t *out, size_t max) {
+    size_t n = 0;
+    while (hex[0] && hex[1] && n < max) {
+        unsigned v;
+        if (sscanf(hex, "%2x", &v) != 1) break;
+        out[n++] = (uint8_t)v;
+        hex += 2;
+    }
+    return n - n % INPUT_LOG_REC_BYTES;
+}
+
+// Phát lại tuần tự: mỗi bước chạy máy trạng thái, đẩy hết ra màn hình rồi mới đo, nên kết quả
+// không phụ thuộc thời gian; timed = true thì chờ đúng khoảng cách đã ghi giữa các phím.
+// Giữ khoá nhập liệu suốt lượt chạy: phím thật và đồng hồ màn hình chờ không chen vào, giao diện
+// bắt đầu từ màn hình chờ với ngày giờ ghim cố định nên cùng một bản ghi luôn cho cùng màn hình
+void input_log_run(const uint8_t *log, size_t n, bool timed, InputStepFn fn, void *arg, InputSummary *out) {
+    memset(out, 0, sizeof(*out));
+    struct tm pin;
+    civil_localtime(civil_mktime(REPLAY_YEAR, REPLAY_MONTH, REPLAY_DAY, REPLAY_HOUR, 0, 0, 0), 0, &pin);
+    ui_input_lock();
+    ui_clock_pin(&pin);
+    ui_reset_locked();
+    fill_screen(COLOR_BLACK);
+    display_flush();
+    for (size_t i = 0; i + INPUT_LOG_REC_BYTES <= n; i += INPUT_LOG_REC_BYTES) {
+        InputStep st = {
+            .index = (uint32_t)(i / INPUT_LOG_REC_BYTES),
+            .delay_ms = (uint16_t)(log[i] | (log[i + 1] << 8)),
+            .btn = log[i + 2] & 0x03,
+            .repeat = log[i + 2] >> 2,
+        };
+        if (timed && st.delay_ms) vTaskDelay(pdMS_TO_TICKS(st.delay_ms));
+        BtnEdges e = { .repeat = st.repeat };
+        switch (st.btn) {
+        case INPUT_BTN_OK:     e.ok_edge = 1; break;
+        case INPUT_BTN_BACK:   e.back_edge = 1; break;
+        case INPUT_BTN_NEXT:   e.next_edge = 1; break;
+        default:               e.cancel_edge = 1; break;
+        }
+        DisplayStats a, b;
+        display_sync();
+        display_stats_get(&a);
+        int64_t t0 = esp_timer_get_time();
+        ui_handle_input(&e);
+        st.state = ui_state;
+        display_flush();
+        display_sync();
+        st.us = (uint32_t)(esp_timer_get_time() - t0);
+        display_stats_get(&b);
+        st.transactions = b.transactions >= a.transactions ? b.transactions - a.transactions : b.transactions;
+        st.bytes = b.bytes >= a.bytes ? b.bytes - a.bytes : b.bytes;
+        out->steps++;
+        out->us += st.us;
+        out->transactions += st.transactions;
+        out->bytes += st.bytes;
+        out->state = st.state;
+        if (fn) fn(&st, arg);
+    }
+#if CONFIG_DISPLAY_MODEL
+    display_sync();
+    out->crc = display_model_checksum();
+#endif
+    ui_clock_pin(NULL);
+    ui_input_unlock();
+}
+
+typedef struct {
+    cJSON *us;
+    cJSON *bytes;
+} ReplayReport;
+
+static void replay_step_log(const InputStep *st, void *arg) {
+    ReplayReport *r = arg;
+    ESP_LOGI(TAG, "#%lu %s%s: %lu us, %lu gói, %lu byte, trạng thái %d", (unsigned long)st->index,
+             btn_names[st->btn], st->repeat ? " (lặp)" : "", (unsigned long)st->us,
+             (unsigned long)st->transactions, (unsigned long)st->bytes, st->state);
+    cJSON_AddItemToArray(r->us, cJSON_CreateNumber(st->us));
+    cJSON_AddItemToArray(r->bytes, cJSON_CreateNumber(st->bytes));
+}
+
+static void replay_task(void *pv) {
+    ReplayJob *job = pv;
+    cJSON *j = cJSON_CreateObject();
+    ReplayReport r = { cJSON_CreateArray(), cJSON_CreateArray() };
+    InputSummary sum;
+    input_log_run(job->data, job->n, job->timed, replay_step_log, &r, &sum);
+    ESP_LOGI(TAG, "Phát lại xong: %lu bước, %llu us, %lu gói, %lu byte, trạng thái %d, màn hình %08lx",
+             (unsigned long)sum.steps, (unsigned long long)sum.us, (unsigned long)sum.transactions,
+             (unsigned long)sum.bytes, sum.state, (unsigned long)sum.crc);
+    cJSON_AddNumberToObject(j, "steps", sum.steps);
+    cJSON_AddNumberToObject(j, "us", (double)sum.us);
+    cJSON_AddNumberToObject(j, "tx", sum.transactions);
+    cJSON_AddNumberToObject(j, "bytes", sum.bytes);
+    cJSON_AddNumberToObject(j, "state", sum.state);
+    char crc[9];
+    snprintf(crc, sizeof(crc), "%08lx", (unsigned long)sum.crc);
+    cJSON_AddStringToObject(j, "crc", crc);
+    cJSON_AddItemToObject(j, "step_us", r.us);
+    cJSON_AddItemToObject(j, "step_bytes", r.bytes);
+    char *s = cJSON_PrintUnformatted(j);
+    if (s) {
+        mqtt_publish("reminders/input/result", s, 0, 0);
+        free(s);
+    }
+    cJSON_Delete(j);
+    free(job);
+    replay_busy = false;
+    vTaskDelete(NULL);
+}
+
+// log = NULL phát lại bản đang ghi trong bộ nhớ
+bool input_log_replay(const uint8_t *log, size_t n, bool timed) {
+    if (replay_busy) {
+        ESP_LOGW(TAG, "Đang phát lại, bỏ qua yêu cầu mới");
+        return false;
+    }
+    if (alarm_pipeline_active()) {
+        ESP_LOGW(TAG, "Đang báo thức, không phát lại");
+        return false;
+    }
+    size_t cap = log ? n : LOG_BYTES;
+    ReplayJob *job = malloc(sizeof(ReplayJob) + cap);
+    if (!job) return false;
+    job->timed = timed;
+    job->n = log ? n : input_log_copy(job->data, cap);
+    if (log) memcpy(job->data, log, n);
+    replay_busy = true;
+    if (xTaskCreate(replay_task, "input_replay", REPLAY_STACK, job, REPLAY_PRIORITY, NULL) != pdPASS) {
+        free(job);
+        replay_busy = false;
+        return false;
+    }
+    return true;
+}
+
+bool input_log_replaying(void) {
+    return replay_busy;
+}
+
+void input_log_publish(void) {
+    uint8_t *buf = malloc(LOG_BYTES);
+    char *hex = malloc(LOG_BYTES * 2 + 1);
+    if (buf && hex) {
+        size_t n = input_log_copy(buf, LOG_BYTES);
+        for (size_t i = 0; i < n; i++) sprintf(&hex[i * 2], "%02x", buf[i]);
+        hex[n * 2] = '\0';
+        cJSON *j = cJSON_CreateObject();
+        cJSON_AddNumberToObject(j, "events", n / INPUT_LOG_REC_BYTES);
+        cJSON_AddStringToObject(j, "log", hex);
+        char *s = cJSON_PrintUnformatted(j);
+        if (s) {
+            mqtt_publish("reminders/input", s, 0, 0);
+            free(s);
+        }
+        cJSON_Delete(j);
+    }
+    free(buf);
+    free(hex);
+}
+
+#endif
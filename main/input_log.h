@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "ui_buttons.h"
+
+// Mỗi sự kiện 3 byte: khoảng cách tới sự kiện trước (ms, u16 LE, bão hòa) rồi nút | lần lặp << 2
+#define INPUT_LOG_REC_BYTES 3
+
+typedef enum { INPUT_BTN_OK = 0, INPUT_BTN_BACK, INPUT_BTN_NEXT, INPUT_BTN_CANCEL } InputBtn;
+
+typedef struct {
+    uint32_t index;
+    uint8_t  btn;
+    uint8_t  repeat;
+    uint16_t delay_ms;
+    uint32_t us;
+    uint32_t transactions;
+    uint32_t bytes;
+    int      state;
+} InputStep;
+
+typedef struct {
+    uint32_t steps;
+    uint64_t us;
+    uint32_t transactions;
+    uint32_t bytes;
+    int      state;
+    uint32_t crc;
+} InputSummary;
+
+typedef void (*InputStepFn)(const InputStep *step, void *arg);
+
+#if CONFIG_BUTTON_INPUT_LOG
+void   input_log_record(const BtnEdges *e);
+void   input_log_start(void);
+void   input_log_stop(void);
+size_t input_log_copy(uint8_t *out, size_t max);
+size_t input_log_from_hex(const char *hex, uint8_t *out, size_t max);
+void   input_log_run(const uint8_t *log, size_t n, bool timed, InputStepFn fn, void *arg, InputSummary *out);
+bool   input_log_replay(const uint8_t *log, size_t n, bool timed);
+void   input_log_publish(void);
+bool   input_log_replaying(void);
+#else
+static inline void input_log_record(const BtnEdges *e) { (void)e; }
+static inline bool input_log_replaying(void) { return false; }
+#endif
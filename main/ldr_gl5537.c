@@ -51,6 +51,7 @@ esp_err_t ldr_gl5537_init(ldr_gl5537_t *ldr, gpio_num_t led_pin, gpio_num_t buzz
     ldr->led_state = 0;
     ldr->is_below_threshold = false;
     ldr->enabled = false;
+    ldr->last_value = -1;
     ldr->mutex = mutex;
     ldr->gesture_callback = NULL;
 
@@ -213,6 +214,7 @@ void ldr_gl5537_task(void *pvParameters) {
     while (1) {
         int ldr_value = ldr_gl5537_read_adc(ldr);
         if (ldr_value >= 0) {
+            ldr->last_value = ldr_value;
             ldr_gl5537_handle_gesture(ldr, ldr_value);
         } else {
             ESP_LOGW(TAG, "ADC read failed, retrying after 100ms");
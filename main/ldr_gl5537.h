@@ -33,6 +33,7 @@ typedef struct {
     int led_state;                        
     bool is_below_threshold;              
     bool enabled;                         
+    volatile int last_value;              
     SemaphoreHandle_t mutex;             
     ldr_gesture_callback_t gesture_callback; 
 } ldr_gl5537_t;
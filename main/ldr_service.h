@@ -9,6 +9,13 @@
 #include "driver/gpio.h"
 #include "ldr_gl5537.h"
 
+#ifndef LDR_LED_PIN
+#define LDR_LED_PIN      GPIO_NUM_42
+#endif
+#ifndef LDR_BUZZER_PIN
+#define LDR_BUZZER_PIN   GPIO_NUM_35
+#endif
+
 extern ldr_gl5537_t ldr;
 
 void ldr_scan_task(void *pv);
@@ -1,10 +1,18 @@
 #include <stdio.h>
 #include "freertos/FreeRTOS.h"
 #include "display.h"
+#include "display_power.h"
 #include "soc/gpio_num.h"
 #include "wifi_app.h"
 #include "sntp.h"
 #include "reminders_store.h"
+#include "sched_sim.h"
+#include "ui_fsm.h"
+#include "ui_perf.h"
+#include "snooze.h"
+#include "civil_time.h"
+#include "gfx.h"
+#include "tz.h"
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_system.h"
@@ -66,12 +74,26 @@ void app_main(void) {
         nvs_flash_erase();
         nvs_flash_init();
     }
+    tz_init();
     load_reminders_from_nvs();
+    snooze_init();
+#if CONFIG_REMINDER_SCHED_SIM
+    sched_sim_start();
+#endif
+#if CONFIG_REMINDER_CALENDAR_BENCH
+    civil_bench_run();
+#endif
+#if CONFIG_DISPLAY_GFX_SELFTEST
+    gfx_selftest_run();
+#endif
 	ESP_LOGI(TAG, "Application started");
     ESP_LOGI(TAG, "Free heap before app_main: %lu bytes", (unsigned long)esp_get_free_heap_size());
     ESP_LOGI(TAG, "Minimum free heap: %lu bytes", (unsigned long)esp_get_minimum_free_heap_size());
 
     init_display();
+    display_power_start();
+    ui_fsm_init();
+    perf_init();
 
     BaseType_t ret_ui = xTaskCreatePinnedToCore(
         ui_task, "ui_task",
@@ -17,6 +17,11 @@
 #include "mqtt_client.h"
 #include "cJSON.h"
 #include "sntp.h"
+#include "tz.h"
+#include "display.h"
+#include "display_model.h"
+#include "ui_perf.h"
+#include "input_log.h"
 
 static const char *TAG = "MQTT";
 
@@ -28,6 +33,7 @@ extern void sync_reminder(const char *action, int id, const char *date, const ch
 extern void update_reminder(int id, const char *date, int hour, int min, const char *content, const char *status);
 
 static esp_mqtt_client_handle_t mqtt_client = NULL;
+static volatile bool connected = false;
 
 static void log_error_if_nonzero(const char *message, int error_code)
 {
@@ -46,6 +52,11 @@ void mqtt_publish(const char *topic, const char *data, int qos, int retain)
     }
 }
 
+bool mqtt_connected(void)
+{
+    return connected;
+}
+
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
     ESP_LOGD(TAG, "Event dispatched from event loop base=%s, event_id=%" PRIi32 "", base, event_id);
@@ -56,6 +67,7 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     switch ((esp_mqtt_event_id_t)event_id) {
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
+        connected = true;
         msg_id = esp_mqtt_client_subscribe(client, "reminders/add", 0);
         ESP_LOGI(TAG, "Subscribed to reminders/add, msg_id=%d", msg_id);
         msg_id = esp_mqtt_client_subscribe(client, "reminders/update", 0);
@@ -69,6 +81,7 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         break;
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+        connected = false;
         break;
     case MQTT_EVENT_SUBSCRIBED:
         ESP_LOGI(TAG, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
@@ -126,6 +139,52 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
                 sync_reminder(action->valuestring, id->valueint, NULL, NULL, NULL, NULL);
             } else if (strcmp(action->valuestring, "update") == 0 && id && cJSON_IsNumber(id)) {
                 sync_reminder(action->valuestring, id->valueint, date->valuestring, time->valuestring, content->valuestring, status->valuestring);
+            } else if (strcmp(action->valuestring, "timezone") == 0) {
+                cJSON *tz = cJSON_GetObjectItem(json, "tz");
+                if (tz && cJSON_IsString(tz)) tz_set(tz->valuestring, true);
+                else ESP_LOGE(TAG, "Thiếu trường tz");
+#if CONFIG_DISPLAY_MODEL
+            } else if (strcmp(action->valuestring, "screenshot") == 0) {
+                DisplayModelStats ms;
+                display_sync();
+                display_model_stats(&ms);
+                ESP_LOGI(TAG, "Model: %lu lệnh, %lu gói dữ liệu, %lu byte, %lu cửa sổ, %lu điểm ảnh, %lu tràn",
+                         (unsigned long)ms.commands, (unsigned long)ms.data_transactions,
+                         (unsigned long)ms.data_bytes, (unsigned long)ms.windows,
+                         (unsigned long)ms.pixels, (unsigned long)ms.overflow_pixels);
+                display_model_dump();
+                display_model_stats_reset();
+#endif
+#if CONFIG_DISPLAY_PERF
+            } else if (strcmp(action->valuestring, "perf") == 0) {
+                cJSON *reset = cJSON_GetObjectItem(json, "reset");
+                perf_log();
+                perf_publish();
+                if (cJSON_IsTrue(reset)) perf_reset();
+#endif
+#if CONFIG_BUTTON_INPUT_LOG
+            } else if (strcmp(action->valuestring, "input") == 0) {
+                cJSON *op = cJSON_GetObjectItem(json, "op");
+                const char *o = (op && cJSON_IsString(op)) ? op->valuestring : "";
+                if (strcmp(o, "record") == 0) {
+                    input_log_start();
+                } else if (strcmp(o, "stop") == 0) {
+                    input_log_stop();
+                } else if (strcmp(o, "dump") == 0) {
+                    input_log_publish();
+                } else if (strcmp(o, "replay") == 0) {
+                    cJSON *log = cJSON_GetObjectItem(json, "log");
+                    bool timed = cJSON_IsTrue(cJSON_GetObjectItem(json, "timed"));
+                    if (log && cJSON_IsString(log)) {
+                        uint8_t buf[128];
+                        input_log_replay(buf, input_log_from_hex(log->valuestring, buf, sizeof(buf)), timed);
+                    } else {
+                        input_log_replay(NULL, 0, timed);
+                    }
+                } else {
+                    ESP_LOGE(TAG, "op không hợp lệ: %s", o);
+                }
+#endif
             } else {
                 ESP_LOGE(TAG, "Action hoặc id không hợp lệ");
             }
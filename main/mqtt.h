@@ -1,6 +1,7 @@
 #ifndef MAIN_MQTT_H_
 #define MAIN_MQTT_H_
 
+#include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "sntp.h"
@@ -12,5 +13,6 @@
 
 void mqtt_app_start(void);
 void mqtt_publish(const char *topic, const char *data, int qos, int retain);
+bool mqtt_connected(void);
 
 #endif 
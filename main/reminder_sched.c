@@ -0,0 +1,103 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "time_utils.h"
+#include "civil_time.h"
+#include "tz.h"
+#include "reminder_sched.h"
+
+#define TAG "Sched"
+
+void reminder_sched_init(SchedState *st, time_t now) {
+    st->last_local_min = -1;
+    st->catch_from = -1;
+    st->last_off = tz_offset_at(now);
+    st->last_tz_gen = tz_generation();
+    st->dropped = 0;
+}
+
+static inline void ctx_lock(const SchedCtx *ctx) {
+    if (ctx->lock) xSemaphoreTake(ctx->lock, portMAX_DELAY);
+}
+
+static inline void ctx_unlock(const SchedCtx *ctx) {
+    if (ctx->lock) xSemaphoreGive(ctx->lock);
+}
+
+bool reminder_sched_step(SchedState *st, const SchedCtx *ctx, time_t now, const struct tm *timeinfo) {
+    bool redraw = false;
+    int time_synced = (timeinfo->tm_year >= (2016 - 1900));
+    int32_t off = tz_offset_at(now);
+    uint32_t tz_gen = tz_generation();
+    long local_min = (long)((now + off) / 60);
+    if (tz_gen != st->last_tz_gen) {
+        st->last_local_min = st->catch_from = -1;
+        redraw = true;
+    } else if (off != st->last_off) {
+        // Qua mốc DST: giờ tiến thì bù các phút bị nhảy qua, giờ lùi thì không báo lặp
+        if (off > st->last_off && st->last_local_min >= 0 && local_min - st->last_local_min <= (off - st->last_off) / 60 + 1)
+            st->catch_from = st->last_local_min + 1;
+        redraw = true;
+    } else if (st->last_local_min - local_min > 120) {
+        st->last_local_min = -1;
+    }
+    st->last_tz_gen = tz_gen;
+    st->last_off = off;
+    SnoozeEntry se;
+    bool busy        = ctx->busy();
+    bool snooze_due  = !busy && snooze_heap_peek(ctx->snoozes, &se) && se.until <= now;
+    bool minute_due  = time_synced && local_min > st->last_local_min;
+    time_t minute_ts = now - timeinfo->tm_sec;
+    if (minute_due && (!snooze_due || minute_ts <= se.until)) {
+        long first_min = (st->catch_from >= 0) ? st->catch_from : local_min;
+        st->last_local_min = local_min;
+        st->catch_from = -1;
+        int dropped = 0, first_drop = -1;
+        ctx_lock(ctx);
+        for (long lm = first_min; lm <= local_min; lm++) {
+            struct tm mt;
+            civil_localtime((time_t)lm * 60, 0, &mt);
+            char today[11]; fmt_date(mt.tm_year+1900, mt.tm_mon+1, mt.tm_mday, today);
+            for (int i = reminders_find_due(ctx->list, *ctx->count, 0, &mt, today); i >= 0;
+                 i = reminders_find_due(ctx->list, *ctx->count, i + 1, &mt, today)) {
+                const Reminder *r = &ctx->list[i];
+                if (ctx->due) ctx->due(r);
+                snooze_heap_cancel(ctx->snoozes, r->id);
+                if (busy) {
+                    if (!snooze_heap_push(ctx->snoozes, r->id, minute_ts, 0) && dropped++ == 0)
+                        first_drop = r->id;
+                    continue;
+                }
+                AlarmInfo info = { .id = r->id, .snooze_count = 0 };
+                fmt_time(r->hour, r->minute, info.time);
+                strcpy(info.date, r->date);
+                strcpy(info.content, r->content);
+                busy = ctx->start(&info);
+                if (busy) redraw = true;
+            }
+        }
+        ctx_unlock(ctx);
+        // Gom lại, ghi log một lần sau khi nhả khoá thay vì mỗi lịch một dòng trong vòng lặp
+        if (dropped) {
+            st->dropped += dropped;
+            if (!ctx->quiet) ESP_LOGW(TAG, "Hàng đợi báo lại đầy, bỏ %d lịch (ID đầu tiên %d)", dropped, first_drop);
+        }
+    } else if (snooze_due && snooze_heap_pop_due(ctx->snoozes, now, &se)) {
+        AlarmInfo info = { .id = se.id, .snooze_count = se.count };
+        bool found = false;
+        ctx_lock(ctx);
+        int idx = reminders_index_of(ctx->list, *ctx->count, se.id);
+        if (idx >= 0 && strncmp(ctx->list[idx].status, "completed", 9) != 0) {
+            strcpy(info.date, ctx->list[idx].date);
+            strcpy(info.content, ctx->list[idx].content);
+            found = true;
+        }
+        ctx_unlock(ctx);
+        if (found) {
+            fmt_time(timeinfo->tm_hour, timeinfo->tm_min, info.time);
+            if (ctx->start(&info)) redraw = true;
+        }
+    }
+    return redraw;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "reminders_store.h"
+#include "snooze.h"
+#include "alarm_pipeline.h"
+
+// Nguồn lịch và nơi nhận báo thức cho một bước lập lịch. Task chính dùng mảng
+// reminders toàn cục và alarm_pipeline; mô phỏng dùng danh sách và hàng đợi riêng.
+typedef struct {
+    Reminder *list;
+    const int *count;
+    SemaphoreHandle_t lock;           // NULL nếu danh sách không dùng chung
+    SnoozeHeap *snoozes;
+    bool (*busy)(void);
+    bool (*start)(const AlarmInfo *info);
+    void (*due)(const Reminder *r);   // mỗi lần một lịch đến hạn, kể cả khi bị hoãn
+    bool quiet;                       // không ghi log lịch bị bỏ, người gọi tự đọc SchedState.dropped
+} SchedCtx;
+
+typedef struct {
+    long last_local_min;
+    long catch_from;
+    int32_t last_off;
+    uint32_t last_tz_gen;
+    uint32_t dropped;                 // số lịch bị bỏ vì hàng đợi báo lại đầy
+} SchedState;
+
+void reminder_sched_init(SchedState *st, time_t now);
+// Xử lý phút mới hoặc một lần báo lại đến hạn; trả về true nếu màn hình chờ cần vẽ lại
+bool reminder_sched_step(SchedState *st, const SchedCtx *ctx, time_t now, const struct tm *timeinfo);
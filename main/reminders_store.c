@@ -8,6 +8,10 @@
 #include "nvs.h"         
 #include "nvs_flash.h"
 #include "mqtt.h"
+#include "snooze.h"
+#include "civil_time.h"
+#include "upcoming.h"
+#include "calendar_index.h"
 #define MAX_REMINDERS 16
 #define TAG "Reminders task"
 
@@ -26,6 +30,41 @@ void recompute_next_id_locked(void) {
     next_id = (maxid > 0) ? (maxid + 1) : 1;
 }
 
+int reminders_index_of(const Reminder *list, int n, int id) {
+    for (int i = 0; i < n; i++) {
+        if (list[i].id == id) return i;
+    }
+    return -1;
+}
+
+int reminder_index_of_locked(int id) {
+    return reminders_index_of(reminders, num_reminders, id);
+}
+
+void reminder_changed_locked(const Reminder *r) {
+    upcoming_put_locked(r);
+    calendar_index_put_locked(r);
+}
+
+static void reminder_removed_locked(int id) {
+    upcoming_remove_locked(id);
+    calendar_index_remove_locked(id);
+}
+
+static void reminders_reindex_locked(void) {
+    upcoming_rebuild_locked();
+    calendar_index_rebuild_locked();
+}
+
+int reminders_find_due(const Reminder *list, int n, int start, const struct tm *t, const char *today) {
+    for (int i = (start > 0 ? start : 0); i < n; i++) {
+        const Reminder *r = &list[i];
+        if (r->hour != t->tm_hour || r->minute != t->tm_min) continue;
+        if (strncmp(r->status, "repeat", 6) == 0 || strncmp(r->date, today, 10) == 0) return i;
+    }
+    return -1;
+}
+
 void reminders_recalc(void) {
     if (!reminders_mutex) return;
     xSemaphoreTake(reminders_mutex, portMAX_DELAY);
@@ -41,6 +80,7 @@ void reminders_recalc(void) {
     }
     num_reminders = count;
     next_id       = (maxid > 0) ? (maxid + 1) : 1;
+    reminders_reindex_locked();
     xSemaphoreGive(reminders_mutex);
 }
 
@@ -59,6 +99,7 @@ void add_reminder_full(int id, const char *date, int hour, int min, const char *
         reminders[idx].status[sizeof(reminders[idx].status) - 1] = 0;
         num_reminders++;
         recompute_next_id_locked();
+        reminder_changed_locked(&reminders[idx]);
         ESP_LOGI(TAG, "Thêm báo thức ID %d: %s %02d:%02d %s %s", 
                  id, date, hour, min, content, status);
         cJSON *add_json = cJSON_CreateObject();
@@ -94,6 +135,7 @@ void add_reminder_full_nr(int id, const char *date, int hour, int min, const cha
         reminders[idx].status[sizeof(reminders[idx].status) - 1] = 0;
         num_reminders++;
         recompute_next_id_locked();
+        reminder_changed_locked(&reminders[idx]);
         ESP_LOGI(TAG, "Thêm báo thức ID %d: %s %02d:%02d %s %s", 
                  id, date, hour, min, content, status);
        
@@ -130,6 +172,7 @@ void update_reminder(int id, const char *date, int hour, int min, const char *co
                     strncpy(reminders[i].status, status, sizeof(reminders[i].status) - 1);
                     reminders[i].status[sizeof(reminders[i].status) - 1] = 0;
                 }
+                reminder_changed_locked(&reminders[i]);
                 ESP_LOGI(TAG, "Cập nhật báo thức ID %d: %s %02d:%02d %s %s", 
                          id, date ? date : reminders[i].date, hour, min, 
                          content ? content : reminders[i].content, status ? status : reminders[i].status);
@@ -181,6 +224,8 @@ void delete_reminder_at(int idx) {
             pick_index = (num_reminders > 0 ? num_reminders - 1 : 0);
         }
         recompute_next_id_locked();
+        snooze_cancel(id);
+        reminder_removed_locked(id);
         ESP_LOGI(TAG, "Xóa báo thức ID %d", id);
         cJSON *delete_json = cJSON_CreateObject();
         cJSON_AddNumberToObject(delete_json, "id", id);
@@ -213,6 +258,8 @@ void delete_reminder_at_nr(int id) {
             pick_index = (num_reminders > 0 ? num_reminders - 1 : 0);
         }
         recompute_next_id_locked();
+        snooze_cancel(id);
+        reminder_removed_locked(id);
         ESP_LOGI(TAG, "Xóa báo thức ID %d tại chỉ số %d", id, idx);
         
     } else {
@@ -231,6 +278,7 @@ void update_reminder_status(int id, const char *status) {
             // strncpy(reminders[i].status, status, STATUS_LENGTH);
             strncpy(reminders[i].status, status, sizeof(reminders[i].status)-1); 
             reminders[i].status[sizeof(reminders[i].status)-1] = 0;
+            reminder_changed_locked(&reminders[i]);
             ESP_LOGI(TAG, "Cập nhật trạng thái báo thức ID %d: %s", id, status);
                 
             cJSON *status_json = cJSON_CreateObject();
@@ -266,6 +314,11 @@ void sync_reminder(const char *action, int id, const char *date, const char *tim
             ESP_LOGE(TAG, "Time không hợp lệ: %s", time);
             return;
         }
+        int y, m, d;
+        if (strncmp(status, "repeat", 6) != 0 && !civil_parse_date(date, &y, &m, &d)) {
+            ESP_LOGE(TAG, "Date không hợp lệ: %s", date);
+            return;
+        }
         int new_id = (id == -1) ? next_id : id;
         ESP_LOGI(TAG, "Gọi add_reminder_full: id=%d", new_id);
         add_reminder_full_nr(new_id, date, hour, min, content, status);
@@ -277,7 +330,8 @@ void sync_reminder(const char *action, int id, const char *date, const char *tim
             if (reminders[i].id == id) {
                 found = true;
                 if (date != NULL && strlen(date) > 0) {
-                    if (strlen(date) != 10 || !strstr(date, "-") || date[4] != '-' || date[7] != '-') {
+                    int y, m, d;
+                    if (!civil_parse_date(date, &y, &m, &d)) {
                         ESP_LOGE(TAG, "Invalid date format for update ID %d: %s", id, date);
                     } else {
                         strncpy(reminders[i].date, date, sizeof(reminders[i].date) - 1);
@@ -306,7 +360,9 @@ void sync_reminder(const char *action, int id, const char *date, const char *tim
                 if (status != NULL && strlen(status) > 0) {
                     strncpy(reminders[i].status, status, sizeof(reminders[i].status) - 1);
                     reminders[i].status[sizeof(reminders[i].status) - 1] = '\0';
+                    if (strcmp(status, "completed") == 0) snooze_cancel(id);
                 }
+                reminder_changed_locked(&reminders[i]);
                 ESP_LOGI(TAG, "Cập nhật báo thức ID %d: %s %02d:%02d %s %s", 
                          id, reminders[i].date, reminders[i].hour, reminders[i].minute, 
                          reminders[i].content, reminders[i].status);
@@ -358,7 +414,7 @@ esp_err_t save_reminders_to_nvs(void) {
     return err;
 }
 
-esp_err_t load_reminders_from_nvs(void) {
+static esp_err_t load_reminders_locked(void) {
     ESP_ERROR_CHECK(nvs_init_once());
     nvs_handle_t h;
     esp_err_t err = nvs_open("reminders", NVS_READONLY, &h);
@@ -384,4 +440,14 @@ esp_err_t load_reminders_from_nvs(void) {
     nvs_close(h);
     ESP_LOGI(TAG, "Loaded %d reminders from NVS", num_reminders);
     return ESP_OK;
+}
+
+// Nạp lại cả mảng và chỉ mục lịch dưới khoá: task UI/MQTT có thể đang đọc chỉ mục
+esp_err_t load_reminders_from_nvs(void) {
+    if (!reminders_mutex) reminders_mutex = xSemaphoreCreateMutex();
+    xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+    esp_err_t err = load_reminders_locked();
+    if (err == ESP_OK) reminders_reindex_locked();
+    xSemaphoreGive(reminders_mutex);
+    return err;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "freertos/task.h"
 #include <stdlib.h>
 #include <stdbool.h>
+#include <time.h>
 #include "esp_err.h"
 #include "esp_log.h"
 #include "cJSON.h"
@@ -27,6 +28,10 @@ extern Reminder reminders[];
 extern SemaphoreHandle_t reminders_mutex;
 
 void recompute_next_id_locked(void);
+int reminder_index_of_locked(int id);
+int reminders_index_of(const Reminder *list, int n, int id);
+void reminder_changed_locked(const Reminder *r);
+int reminders_find_due(const Reminder *list, int n, int start, const struct tm *t, const char *today);
 void reminders_recalc(void);
 void add_reminder_full(int id, const char *date, int hour, int min, const char *content, const char *status);
 void add_reminder_full_nr(int id, const char *date, int hour, int min, const char *content, const char *status);
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "reminders_store.h"
+#include "time_utils.h"
+#include "clock_source.h"
+#include "tz.h"
+#include "snooze.h"
+#include "reminder_sched.h"
+#include "sched_sim.h"
+
+#define TAG "SchedSim"
+#define SIM_TASK_STACK_SIZE 4096
+#define SIM_TASK_PRIORITY   1
+#define SIM_TASK_CORE_ID    0
+
+#if CONFIG_REMINDER_SCHED_SIM
+
+static uint32_t sim_rand(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+static long sim_fill(Reminder *list, int n, time_t start, int days) {
+    uint32_t seed = 0x5EED2025u;
+    long expected = 0;
+    for (int i = 0; i < n; i++) {
+        Reminder *r = &list[i];
+        struct tm d;
+        r->id     = i + 1;
+        r->hour   = (int)(sim_rand(&seed) % 24);
+        r->minute = (int)(sim_rand(&seed) % 60);
+        snprintf(r->content, sizeof(r->content), "SIM %d", i + 1);
+        if (sim_rand(&seed) % 10 == 0) {
+            clock_localtime(start, &d);
+            strcpy(r->status, "repeat");
+            expected += days;
+        } else {
+            clock_localtime(start + (time_t)(sim_rand(&seed) % days) * 86400, &d);
+            strcpy(r->status, "pending");
+            expected++;
+        }
+        fmt_date(d.tm_year + 1900, d.tm_mon + 1, d.tm_mday, r->date);
+    }
+    return expected;
+}
+
+// Hàng báo thức giả: mỗi lần báo chiếm pipeline alarm_secs giây rồi được tắt
+static time_t sim_now, sim_busy_until, sim_alarm_secs;
+static time_t *sim_due_at;
+static long sim_fired, sim_deferred;
+static time_t sim_max_delay;
+static SnoozeHeap sim_snoozes;
+
+static bool sim_busy(void) {
+    return sim_busy_until > sim_now;
+}
+
+static bool sim_start(const AlarmInfo *info) {
+    time_t delay = sim_now - sim_due_at[info->id];
+    if (delay > 0) {
+        sim_deferred++;
+        if (delay > sim_max_delay) sim_max_delay = delay;
+    }
+    sim_fired++;
+    sim_busy_until = sim_now + sim_alarm_secs;
+    return sim_alarm_secs > 0;
+}
+
+static void sim_due(const Reminder *r) {
+    sim_due_at[r->id] = sim_now - sim_now % 60;
+}
+
+void sched_sim_run(void) {
+    const int n    = CONFIG_REMINDER_SIM_COUNT;
+    const int days = CONFIG_REMINDER_SIM_DAYS;
+    Reminder *list = calloc(n, sizeof(Reminder));
+    sim_due_at = calloc(n + 1, sizeof(time_t));
+    if (!list || !sim_due_at) {
+        ESP_LOGE(TAG, "Không đủ bộ nhớ cho %d lịch mô phỏng", n);
+        free(list);
+        free(sim_due_at);
+        return;
+    }
+    time_t start = tz_mktime(2025, 1, 1, 0, 0, 0);
+    time_t end   = start + (time_t)days * 86400;
+    long expected = sim_fill(list, n, start, days);
+
+    sim_alarm_secs = CONFIG_REMINDER_SIM_ALARM_SECS;
+    sim_busy_until = 0;
+    sim_fired = sim_deferred = 0;
+    sim_max_delay = 0;
+    snooze_heap_clear(&sim_snoozes);
+    SchedCtx ctx = {
+        .list = list, .count = &n, .lock = NULL, .snoozes = &sim_snoozes,
+        .busy = sim_busy, .start = sim_start, .due = sim_due, .quiet = true,
+    };
+    SchedState st;
+    reminder_sched_init(&st, start);
+
+    int64_t day_min = INT64_MAX, day_max = 0;
+    int cur_day = 0;
+    int64_t total_us = 0, t_day = esp_timer_get_time();
+
+    // Không chạy theo nhịp 100 ms như task thật: nhảy thẳng tới phút kế tiếp, lúc
+    // pipeline rảnh hoặc lúc lần báo lại đầu hàng đến hạn, tuỳ cái nào sớm hơn
+    time_t t = start;
+    while (t < end) {
+        struct tm ti;
+        clock_localtime(t, &ti);
+        int day = (int)((t - start) / 86400);
+        if (day != cur_day) {
+            int64_t spent = esp_timer_get_time() - t_day;
+            total_us += spent;
+            spent /= day - cur_day;
+            if (spent < day_min) day_min = spent;
+            if (spent > day_max) day_max = spent;
+            cur_day = day;
+            // Nhường CPU sau mỗi ngày mô phỏng để task idle và watchdog không bị bỏ đói
+            vTaskDelay(1);
+            t_day = esp_timer_get_time();
+        }
+        sim_now = t;
+        reminder_sched_step(&st, &ctx, t, &ti);
+        time_t next = t - ti.tm_sec + 60;
+        // Bước vừa rồi lo lần báo lại trước: task thật xử lý phút này ở vòng 100 ms kế tiếp
+        if (st.last_local_min < (long)((t + tz_offset_at(t)) / 60)) next = t;
+        SnoozeEntry se;
+        if (snooze_heap_peek(&sim_snoozes, &se)) {
+            time_t wake = se.until > sim_busy_until ? se.until : sim_busy_until;
+            if (wake < t) wake = t;
+            if (wake < next) next = wake;
+        }
+        t = next;
+    }
+    total_us += esp_timer_get_time() - t_day;
+    long left = sim_snoozes.len;
+    snooze_heap_clear(&sim_snoozes);
+    free(list);
+    free(sim_due_at);
+    sim_due_at = NULL;
+
+    ESP_LOGI(TAG, "Mô phỏng %d ngày, %d lịch: %.2f s CPU", days, n, total_us / 1e6);
+    // Hàng đợi báo lại chỉ có MAX_REMINDERS chỗ như trên máy thật, lịch tràn ra bị bỏ và được đếm riêng
+    ESP_LOGI(TAG, "Kỳ vọng %ld lần báo, đã báo %ld, bỏ lỡ %ld (còn trong hàng đợi báo lại %ld, "
+             "bỏ vì hàng đợi %d chỗ đầy %lu)",
+             expected, sim_fired, expected - sim_fired, left, MAX_REMINDERS, (unsigned long)st.dropped);
+    ESP_LOGI(TAG, "Báo trễ do đang có báo thức: %ld lần, trễ tối đa %ld s",
+             sim_deferred, (long)sim_max_delay);
+    ESP_LOGI(TAG, "CPU mỗi ngày mô phỏng: trung bình %lld us, min %lld us, max %lld us",
+             (long long)(total_us / days), (long long)(day_min == INT64_MAX ? 0 : day_min), (long long)day_max);
+}
+
+static void sched_sim_task(void *arg) {
+    sched_sim_run();
+    vTaskDelete(NULL);
+}
+
+void sched_sim_start(void) {
+    if (xTaskCreatePinnedToCore(sched_sim_task, "sched_sim", SIM_TASK_STACK_SIZE, NULL,
+                                SIM_TASK_PRIORITY, NULL, SIM_TASK_CORE_ID) != pdPASS) {
+        ESP_LOGE(TAG, "Không tạo được task mô phỏng");
+    }
+}
+
+#else
+
+void sched_sim_run(void) {
+    ESP_LOGW(TAG, "CONFIG_REMINDER_SCHED_SIM chưa bật");
+}
+
+void sched_sim_start(void) {
+    sched_sim_run();
+}
+
+#endif
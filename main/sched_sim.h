@@ -0,0 +1,4 @@
+#pragma once
+
+void sched_sim_run(void);
+void sched_sim_start(void);
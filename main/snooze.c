@@ -0,0 +1,138 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "reminders_store.h"
+#include "snooze.h"
+
+#define TAG "Snooze"
+
+SnoozeHeap snooze_queue;
+
+static inline void swap_at(SnoozeHeap *h, int a, int b) {
+    SnoozeEntry t = h->e[a]; h->e[a] = h->e[b]; h->e[b] = t;
+}
+
+static void sift_up(SnoozeHeap *h, int i) {
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (h->e[p].until <= h->e[i].until) break;
+        swap_at(h, p, i);
+        i = p;
+    }
+}
+
+static void sift_down(SnoozeHeap *h, int i) {
+    for (;;) {
+        int l = 2*i + 1, r = l + 1, m = i;
+        if (l < h->len && h->e[l].until < h->e[m].until) m = l;
+        if (r < h->len && h->e[r].until < h->e[m].until) m = r;
+        if (m == i) break;
+        swap_at(h, i, m);
+        i = m;
+    }
+}
+
+static void remove_at(SnoozeHeap *h, int i) {
+    h->e[i] = h->e[--h->len];
+    if (i < h->len) {
+        sift_up(h, i);
+        sift_down(h, i);
+    }
+}
+
+static int find_locked(const SnoozeHeap *h, int id) {
+    for (int i = 0; i < h->len; i++) {
+        if (h->e[i].id == id) return i;
+    }
+    return -1;
+}
+
+bool snooze_heap_push(SnoozeHeap *h, int id, time_t until, int count) {
+    if (!h->mutex) h->mutex = xSemaphoreCreateMutex();
+    xSemaphoreTake(h->mutex, portMAX_DELAY);
+    int i = find_locked(h, id);
+    if (i >= 0) {
+        remove_at(h, i);
+    } else if (h->len >= MAX_REMINDERS) {
+        xSemaphoreGive(h->mutex);
+        return false;
+    }
+    h->e[h->len] = (SnoozeEntry){ .id = id, .until = until, .count = count };
+    sift_up(h, h->len++);
+    xSemaphoreGive(h->mutex);
+    return true;
+}
+
+void snooze_heap_cancel(SnoozeHeap *h, int id) {
+    if (!h->mutex) return;
+    xSemaphoreTake(h->mutex, portMAX_DELAY);
+    int i = find_locked(h, id);
+    if (i >= 0) remove_at(h, i);
+    xSemaphoreGive(h->mutex);
+}
+
+void snooze_heap_clear(SnoozeHeap *h) {
+    if (!h->mutex) return;
+    xSemaphoreTake(h->mutex, portMAX_DELAY);
+    h->len = 0;
+    xSemaphoreGive(h->mutex);
+}
+
+bool snooze_heap_peek(SnoozeHeap *h, SnoozeEntry *out) {
+    if (!h->mutex) return false;
+    xSemaphoreTake(h->mutex, portMAX_DELAY);
+    bool any = h->len > 0;
+    if (any && out) *out = h->e[0];
+    xSemaphoreGive(h->mutex);
+    return any;
+}
+
+bool snooze_heap_pop_due(SnoozeHeap *h, time_t now, SnoozeEntry *out) {
+    if (!h->mutex) return false;
+    xSemaphoreTake(h->mutex, portMAX_DELAY);
+    bool due = h->len > 0 && h->e[0].until <= now;
+    if (due) {
+        if (out) *out = h->e[0];
+        remove_at(h, 0);
+    }
+    xSemaphoreGive(h->mutex);
+    return due;
+}
+
+void snooze_init(void) {
+    if (!snooze_queue.mutex) snooze_queue.mutex = xSemaphoreCreateMutex();
+}
+
+bool snooze_schedule(int id, time_t until, int count) {
+    if (count > SNOOZE_MAX_REPEATS) {
+        ESP_LOGW(TAG, "Báo thức ID %d đã báo lại %d lần, dừng báo lại", id, count - 1);
+        snooze_cancel(id);
+        return false;
+    }
+    if (!snooze_heap_push(&snooze_queue, id, until, count)) {
+        ESP_LOGE(TAG, "Hàng đợi báo lại đã đầy");
+        return false;
+    }
+    ESP_LOGI(TAG, "Báo lại ID %d lần %d/%d", id, count, SNOOZE_MAX_REPEATS);
+    return true;
+}
+
+void snooze_cancel(int id) {
+    snooze_heap_cancel(&snooze_queue, id);
+}
+
+void snooze_clear(void) {
+    snooze_heap_clear(&snooze_queue);
+}
+
+bool snooze_peek(SnoozeEntry *out) {
+    return snooze_heap_peek(&snooze_queue, out);
+}
+
+bool snooze_pop_due(time_t now, SnoozeEntry *out) {
+    return snooze_heap_pop_due(&snooze_queue, now, out);
+}
+
+int snooze_pending(void) {
+    return snooze_queue.len;
+}
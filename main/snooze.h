@@ -0,0 +1,39 @@
+#pragma once
+#include <stdbool.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "reminders_store.h"
+
+#define SNOOZE_SECS         CONFIG_REMINDER_SNOOZE_SECS
+#define SNOOZE_MAX_REPEATS  CONFIG_REMINDER_SNOOZE_MAX_REPEATS
+
+typedef struct {
+    int    id;
+    time_t until;
+    int    count;
+} SnoozeEntry;
+
+// Min-heap theo thời điểm báo lại; mutex được tạo khi dùng lần đầu
+typedef struct {
+    SnoozeEntry e[MAX_REMINDERS];
+    int len;
+    SemaphoreHandle_t mutex;
+} SnoozeHeap;
+
+extern SnoozeHeap snooze_queue;
+
+bool snooze_heap_push(SnoozeHeap *h, int id, time_t until, int count);
+void snooze_heap_cancel(SnoozeHeap *h, int id);
+void snooze_heap_clear(SnoozeHeap *h);
+bool snooze_heap_peek(SnoozeHeap *h, SnoozeEntry *out);
+bool snooze_heap_pop_due(SnoozeHeap *h, time_t now, SnoozeEntry *out);
+
+void snooze_init(void);
+bool snooze_schedule(int id, time_t until, int count);
+void snooze_cancel(int id);
+void snooze_clear(void);
+bool snooze_peek(SnoozeEntry *out);
+bool snooze_pop_due(time_t now, SnoozeEntry *out);
+int  snooze_pending(void);
@@ -12,9 +12,12 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_sntp.h"
+#include "esp_wifi.h"
 #include "esp_system.h"
 #include "driver/gpio.h"
 #include "display.h"                                
+#include "display_power.h"
+#include "ui_perf.h"
 #include "ldr_gl5537.h"
 #include "mqtt.h"
 #include "send_email.h"
@@ -26,39 +29,44 @@
 #include "ui_draw.h"
 #include "ldr_service.h"
 #include "time_utils.h"
+#include "clock_source.h"
+#include "civil_time.h"
+#include "tz.h"
+#include "snooze.h"
+#include "alarm_pipeline.h"
+#include "reminder_sched.h"
+#include "input_log.h"
+#include "ui_fsm.h"
 
-#define SET_STATE(S)  do { ui_state = (S); ui_epoch++; } while (0)
-
-#ifndef LDR_LED_PIN
-#define LDR_LED_PIN      GPIO_NUM_42
-#endif
-#ifndef LDR_BUZZER_PIN
-#define LDR_BUZZER_PIN   GPIO_NUM_35
-#endif
-#define EV_ALARM_START  (1<<0)   
-#define EV_GESTURE_DONE (1<<1) 
-#define SNOOZE_SECS  (5*60)
-    
-static TaskHandle_t ldr_task_handle = NULL;
-static bool edit_active = false;
-static int edit_day = 1, edit_month = 1, edit_year = 2025; 
-static int edit_hour = 0, edit_min = 0;
 static SemaphoreHandle_t ldr_mutex = NULL;
-static EventGroupHandle_t eg_alarm = NULL;
-static volatile int ldr_cb_code = -1;
-static time_t alarm_started_at = 0;
-static int  alarm_index  = -1;
-static time_t snooze_until = 0;
-static int snooze_index = -1;
-static time_t first_swipe_ts  = 0;
-static int shown_hour = -1, shown_min = -1;
-static int shown_y = -1, shown_m = -1, shown_d = -1;
-static volatile bool  alarm_active = false;
-static bool alarm_screen_visible = false;
+static volatile int shown_hour = -1, shown_min = -1;
+static volatile int shown_y = -1, shown_m = -1, shown_d = -1;
+static volatile int shown_status = -1;
 
 TaskHandle_t mail_task = NULL;
 
-static void ldr_cb(int code) { ldr_cb_code = code; }
+void idle_screen_invalidate(void) {
+    shown_hour = shown_min = -1;
+    shown_y = shown_m = shown_d = -1;
+    shown_status = -1;
+}
+
+static int idle_status_flags(void) {
+    wifi_ap_record_t ap;
+    int f = 0;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) f |= IDLE_ST_WIFI;
+    if (mqtt_connected()) f |= IDLE_ST_MQTT;
+    if (snooze_pending() > 0) f |= IDLE_ST_SNOOZE;
+    return f;
+}
+
+#if CONFIG_DISPLAY_FB_PAL4
+static bool is_night_hour(int h) {
+    int from = CONFIG_DISPLAY_NIGHT_FROM_HOUR, to = CONFIG_DISPLAY_NIGHT_TO_HOUR;
+    if (from == to) return false;
+    return (from < to) ? (h >= from && h < to) : (h >= from || h < to);
+}
+#endif
 
 void time_sync_notification_cb(struct timeval *tv) {
     if (tv) {
@@ -84,9 +92,8 @@ void obtain_time(void) {
     ESP_LOGI(TAG, "Starting SNTP sync...");
     ESP_LOGI(TAG, "Free heap before SNTP init: %lu bytes", (unsigned long)esp_get_free_heap_size());
     initialize_sntp();
-    setenv("TZ", "ICT-7", 1);
-    tzset();
-    ESP_LOGI(TAG, "Timezone set to ICT-7");
+    char tz_spec[TZ_SPEC_MAX]; tz_get(tz_spec, sizeof(tz_spec));
+    ESP_LOGI(TAG, "Timezone set to %s", tz_spec);
     mqtt_app_start();
     time_t now;
     struct tm timeinfo;
@@ -94,8 +101,7 @@ void obtain_time(void) {
     int retry = 60;
     const int retry_count = 60;
     while (retry-- > 0) {
-        time(&now);
-        localtime_r(&now, &timeinfo);
+        clock_now_local(&now, &timeinfo);
         if (timeinfo.tm_year > (2016 - 1900)) {
             strftime(strftime_buf, sizeof(strftime_buf), "%d.%m.%Y %H:%M:%S", &timeinfo);
             ESP_LOGI(TAG, "Time synchronized: %s", strftime_buf);
@@ -107,100 +113,22 @@ void obtain_time(void) {
     ESP_LOGE(TAG, "SNTP sync failed after %d attempts", retry_count);
 }
 
-static void ldr_event_task(void *pv) {
-    ESP_LOGI(TAG, "LDR task: waiting for alarm events...");
-    for (;;) {
-        xEventGroupWaitBits(eg_alarm, EV_ALARM_START, pdTRUE, pdTRUE, portMAX_DELAY);
-        ldr_cb_code = -1;
-        time(&alarm_started_at);
-        first_swipe_ts = 0;
-        ldr_gl5537_set_enabled(&ldr, true); 
-		gpio_set_level(LDR_BUZZER_PIN, 1);             
-        time_t nowt;
-        TickType_t last = xTaskGetTickCount();
-        bool decided = false;
-        while (!decided) {
-            time(&nowt);
-            if (ldr_cb_code < 0 && (nowt - alarm_started_at) >= 180) {
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-                update_reminder_status(reminders[alarm_index].id, "repeat");
-                strncpy(reminders[alarm_index].status, "repeat", sizeof(reminders[alarm_index].status)-1);
-                reminders[alarm_index].status[sizeof(reminders[alarm_index].status)-1] = 0;
-                xSemaphoreGive(reminders_mutex);
-                snooze_index = alarm_index;
-                snooze_until = nowt + SNOOZE_SECS;
-                if (ui_state == UI_IDLE) show_alarm_feedback("BAO LAI SAU 5 PHUT", COLOR_YELLOW);
-                vTaskDelay(pdMS_TO_TICKS(900));
-                gpio_set_level(LDR_BUZZER_PIN, 0);
-                alarm_active = false; alarm_screen_visible = false;
-                shown_hour = shown_min = -1; shown_y = shown_m = shown_d = -1;
-                draw_idle_screen_now();
-                decided = true;
-                break;
-            }
-            int code = ldr_cb_code;
-            if (code == 2) {
-                int was_pending = 0;
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-                update_reminder_status(reminders[alarm_index].id, "repeat");
-                was_pending = (strncasecmp(reminders[alarm_index].status, "pending", 7) == 0);
-                strncpy(reminders[alarm_index].status, "repeat", sizeof(reminders[alarm_index].status)-1);
-                reminders[alarm_index].status[sizeof(reminders[alarm_index].status)-1] = 0;
-                if (was_pending) {
-                    struct tm tm_now = *localtime(&nowt);
-                    int total = tm_now.tm_hour*60 + tm_now.tm_min + 5;
-                    reminders[alarm_index].hour   = (total/60)%24;
-                    reminders[alarm_index].minute = (total%60);
-                }
-                xSemaphoreGive(reminders_mutex);
-                snooze_index = alarm_index;
-                snooze_until = nowt + SNOOZE_SECS;
-                if (ui_state == UI_IDLE) show_alarm_feedback("BAO LAI SAU 5 PHUT", COLOR_YELLOW);
-                vTaskDelay(pdMS_TO_TICKS(900));
-                gpio_set_level(LDR_BUZZER_PIN, 0);
-                alarm_active = false; alarm_screen_visible = false;
-                shown_hour = shown_min = -1; shown_y = shown_m = shown_d = -1;
-                draw_idle_screen_now();
-                decided = true;
-            }
-            else if (code == 0) {
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-                update_reminder_status(reminders[alarm_index].id, "completed");
-                strncpy(reminders[alarm_index].status, "completed", sizeof(reminders[alarm_index].status)-1);
-                reminders[alarm_index].status[sizeof(reminders[alarm_index].status)-1] = 0;
-                xSemaphoreGive(reminders_mutex);
-                snooze_index = -1;
-                if (ui_state == UI_IDLE) show_alarm_feedback("DA HOAN THANH", COLOR_GREEN);
-                vTaskDelay(pdMS_TO_TICKS(900));
-                gpio_set_level(LDR_BUZZER_PIN, 0);
-                alarm_active = false; alarm_screen_visible = false;
-                shown_hour = shown_min = -1; shown_y = shown_m = shown_d = -1;
-                draw_idle_screen_now();
-                decided = true;
-            }
-            vTaskDelayUntil(&last, pdMS_TO_TICKS(20));
-        }
-        gpio_set_level(LDR_BUZZER_PIN, 0);
-        ldr_gl5537_set_enabled(&ldr, false);
-        xEventGroupSetBits(eg_alarm, EV_GESTURE_DONE);
-    }
+static void sched_history(const Reminder *r) {
+    send_reminder_history(r->content);
 }
 
 void print_time_task(void *pvParam) {
-    if (!eg_alarm)  eg_alarm  = xEventGroupCreate();
     if (!ldr_mutex) ldr_mutex = xSemaphoreCreateMutex();
     ESP_ERROR_CHECK(ldr_gl5537_init(&ldr, LDR_LED_PIN, LDR_BUZZER_PIN, LDR_ADC_CHANNEL, ldr_mutex));
     ldr.double_swipe_time_ms = 5000;  
     ldr.scan_interval_ms     = 20;      
-    ldr_gl5537_set_callback(&ldr, ldr_cb);
+    ldr_gl5537_set_callback(&ldr, alarm_pipeline_on_gesture);
     ldr_gl5537_set_enabled(&ldr, false);  
     static TaskHandle_t ldr_scan_handle = NULL;
     if (ldr_scan_handle == NULL) {
         xTaskCreatePinnedToCore(ldr_scan_task, "ldr_scan", 3072, NULL, 5, &ldr_scan_handle, 0);
     }
-    if (ldr_task_handle == NULL) {
-        xTaskCreatePinnedToCore(ldr_event_task, "ldr_evt", 4096, NULL, 6, &ldr_task_handle, 0);
-    }
+    alarm_pipeline_init();
     if (!reminders_mutex) {
         reminders_mutex = xSemaphoreCreateMutex();
     }
@@ -213,139 +141,72 @@ void print_time_task(void *pvParam) {
 	reminders_recalc();
     TickType_t pt_last = xTaskGetTickCount();
     ESP_LOGI(TAG, "Starting reminder task");
-    int last_checked_minute = -1;
+    SchedCtx sched_ctx = {
+        .list = reminders, .count = &num_reminders, .lock = reminders_mutex, .snoozes = &snooze_queue,
+        .busy = alarm_pipeline_active, .start = alarm_pipeline_start, .due = sched_history,
+    };
+    SchedState sched;
+    reminder_sched_init(&sched, clock_now());
+#if CONFIG_DISPLAY_FB_PAL4
+    int night = -1;
+#endif
     while (1) {
-        time_t now; struct tm timeinfo; char time_buf[64];
-        time(&now); localtime_r(&now, &timeinfo);
+        time_t now; struct tm timeinfo;
+        clock_now_local(&now, &timeinfo);
         int time_synced = (timeinfo.tm_year >= (2016 - 1900));
             if (!time_synced) {
                 ESP_LOGI(TAG, "CHUA DONG BO THOI GIAN");
             }
-            if (time_synced && timeinfo.tm_min != last_checked_minute) {
-                last_checked_minute = timeinfo.tm_min;
-                char today[11]; fmt_date(timeinfo.tm_year+1900, timeinfo.tm_mon+1, timeinfo.tm_mday, today);
-                bool took=false, released=false;
-                if (reminders_mutex) { xSemaphoreTake(reminders_mutex, portMAX_DELAY); took=true; }
-                for (int i=0; i<num_reminders; i++) {
-                    bool is_repeat = (strncmp(reminders[i].status, "repeat", 6) == 0);
-                    bool is_today  = (strncmp(reminders[i].date, today, 10) == 0);
-                    if ((is_repeat || is_today) &&
-                    timeinfo.tm_hour == reminders[i].hour &&
-                    timeinfo.tm_min  == reminders[i].minute) {
-                        int    r_hour = reminders[i].hour;
-                        int    r_min  = reminders[i].minute;
-                        char   r_cont[64]; strcpy(r_cont, reminders[i].content);
-                        char   r_date[11]; strcpy(r_date, reminders[i].date);
-                        int    idx = i;
-                        send_reminder_history(r_cont);
-                        if (took && !released) { xSemaphoreGive(reminders_mutex); released=true; }
-                        char tbuf[6]; fmt_time(r_hour, r_min, tbuf);
-                        if (ui_state == UI_IDLE) {
-                            fill_screen(COLOR_BLACK);
-                            // gpio_set_level(LDR_BUZZER_PIN, 1);
-                            draw_string(10, 10, "NHAC NHO:", COLOR_GREEN);
-                            draw_string(10, 40, tbuf, COLOR_WHITE);
-                            draw_string(10, 70, r_cont, COLOR_WHITE);
-                            draw_string(10, 90, r_date, COLOR_YELLOW);
-                            shown_hour = shown_min = -1;
-                            shown_y = shown_m = shown_d = -1;
-                            alarm_screen_visible = true;
-    						// xTaskCreatePinnedToCore(send_email, "mail_alarm_due", 4096, NULL, 4, NULL, 0);
-							if (mail_task == NULL) {
-    							xTaskCreatePinnedToCore(send_email, "mail_alarm_due", 12288, NULL, 2, &mail_task, 1);
-							}
-                        }
-                        taskYIELD();
-                        alarm_active = true;
-                        alarm_index  = idx;
-                        time(&alarm_started_at);
-                        first_swipe_ts = 0;
-                        snooze_index = -1; snooze_until = 0;
-                        xEventGroupSetBits(eg_alarm, EV_ALARM_START);  
-                        xEventGroupWaitBits(eg_alarm, EV_GESTURE_DONE, pdTRUE, pdTRUE, portMAX_DELAY);
-                        break;                             
-                    }
-                }
-                if (took && !released) xSemaphoreGive(reminders_mutex); 
-            }
-		if (!alarm_active && snooze_index >= 0) {
-    		time_t nowt; time(&nowt);
-    		if (nowt >= snooze_until) {
-        	Reminder rr;
-        	if (reminders_mutex) xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-        	rr = reminders[snooze_index];
-        	if (reminders_mutex) xSemaphoreGive(reminders_mutex);
-        	char tb[6]; fmt_time(timeinfo.tm_hour, timeinfo.tm_min, tb);
-        	if (ui_state == UI_IDLE) {
-            	fill_screen(COLOR_BLACK);
-            	// gpio_set_level(LDR_BUZZER_PIN, 1);
-            	draw_string(10, 10, "NHAC NHO:", COLOR_GREEN);
-            	draw_string(10, 40, tb, COLOR_WHITE);
-            	draw_string(10, 70, rr.content, COLOR_WHITE);
-            	draw_string(10, 90, rr.date, COLOR_YELLOW);
-                shown_hour = shown_min = -1;
-                shown_y = shown_m = shown_d = -1;
-                alarm_screen_visible = true;
-        	}
-            taskYIELD(); 
-        	alarm_active = true;
-        	alarm_index  = snooze_index;
-            time(&alarm_started_at);
-            first_swipe_ts = 0;
-            xEventGroupSetBits(eg_alarm, EV_ALARM_START);
-            xEventGroupWaitBits(eg_alarm, EV_GESTURE_DONE, pdTRUE, pdTRUE, portMAX_DELAY);
-    		}
-		}
-        if (ui_state == UI_IDLE && !alarm_screen_visible) {
+            if (reminder_sched_step(&sched, &sched_ctx, now, &timeinfo)) idle_screen_invalidate();
+#if CONFIG_DISPLAY_FB_PAL4
+        if (time_synced && is_night_hour(timeinfo.tm_hour) != night) {
+            night = is_night_hour(timeinfo.tm_hour);
+            display_set_night(night);
+        }
+#endif
+        // ui_state chỉ đọc khi giữ khoá nhập liệu để khung màn hình chờ không chen sau khung menu;
+        // khoá đang bận (phím, phát lại) thì bỏ lượt này, vòng 100 ms sau vẽ bù
+        bool idle_locked = ui_input_trylock();
+        if (idle_locked && ui_state == UI_IDLE && !alarm_pipeline_screen_visible()) {
             if (shown_hour == -1 || shown_min == -1 || shown_y==-1) {
-                fill_screen(COLOR_BLACK);
-                const char *title = "THOI GIAN HIEN TAI";
-                int tx = (TFT_WIDTH - (int)strlen(title) * FONT_W)/2;
-                draw_string(tx, 20, title, COLOR_GREEN);
-                idle_x = (TFT_WIDTH  - 5 * FONT_W)/2;   
-                idle_y = (TFT_HEIGHT - FONT_H)/2 - 6;
-                char buf[6];
-                fmt_time(timeinfo.tm_hour, timeinfo.tm_min, buf);
-                draw_string(idle_x, idle_y, buf, COLOR_WHITE);
-                char datebuf[11];
-                int cy = timeinfo.tm_year + 1900, cm = timeinfo.tm_mon + 1, cd = timeinfo.tm_mday;
-                fmt_date(cy, cm, cd, datebuf);
-                int dx = (TFT_WIDTH - (int)strlen(datebuf)*FONT_W)/2;
-                draw_string(dx, idle_y + FONT_H + 6, datebuf, COLOR_YELLOW);
+                shown_status = idle_status_flags();
+                draw_idle_screen_now(&timeinfo, shown_status);
                 shown_hour = timeinfo.tm_hour;
                 shown_min  = timeinfo.tm_min;
-                shown_y = cy; shown_m = cm; shown_d = cd;
-                idle_draw_upcoming(&timeinfo);
+                shown_y = timeinfo.tm_year + 1900; shown_m = timeinfo.tm_mon + 1; shown_d = timeinfo.tm_mday;
             } else {
-                if (timeinfo.tm_hour != shown_hour) {
-                    char hh[3] = { (char)('0'+(timeinfo.tm_hour/10)), (char)('0'+(timeinfo.tm_hour%10)), 0 };
-                    fill_rect(idle_x, idle_y, 2 * FONT_W, FONT_H, COLOR_BLACK);
-                    draw_string(idle_x, idle_y, hh, COLOR_WHITE);
+                if (timeinfo.tm_hour != shown_hour || timeinfo.tm_min != shown_min) {
+                    PerfFrame pf = perf_frame_begin(SCR_IDLE);
+                    idle_draw_clock(timeinfo.tm_hour, timeinfo.tm_min, shown_hour, shown_min);
                     shown_hour = timeinfo.tm_hour;
+                    shown_min  = timeinfo.tm_min;
                     idle_draw_upcoming(&timeinfo);
+                    perf_frame_end(pf);
                 }
-                if (timeinfo.tm_min != shown_min) {
-                    char mm[3] = { (char)('0'+(timeinfo.tm_min/10)), (char)('0'+(timeinfo.tm_min%10)), 0 };
-                    int mx = idle_x + 3 * FONT_W;
-                    fill_rect(mx, idle_y, 2 * FONT_W, FONT_H, COLOR_BLACK);
-                    draw_string(mx, idle_y, mm, COLOR_WHITE);
-                    shown_min = timeinfo.tm_min;
-                    idle_draw_upcoming(&timeinfo);
+                int st = idle_status_flags();
+                if (st != shown_status) {
+                    PerfFrame pf = perf_frame_begin(SCR_IDLE);
+                    idle_draw_status(st, shown_status);
+                    shown_status = st;
+                    perf_frame_end(pf);
                 }
                 int cy = timeinfo.tm_year + 1900, cm = timeinfo.tm_mon + 1, cd = timeinfo.tm_mday;
                 if (cy!=shown_y || cm!=shown_m || cd!=shown_d) {
                     char datebuf[11];
                     fmt_date(cy, cm, cd, datebuf);
                     int dx = (TFT_WIDTH - (int)strlen(datebuf)*FONT_W)/2;
-                    fill_rect(0, idle_y + FONT_H + 6, TFT_WIDTH, FONT_H, COLOR_BLACK);
-                    draw_string(dx, idle_y + FONT_H + 6, datebuf, COLOR_YELLOW);
+                    fill_rect(0, idle_y + IDLE_DATE_DY, TFT_WIDTH, FONT_H, COLOR_BLACK);
+                    draw_string(dx, idle_y + IDLE_DATE_DY, datebuf, COLOR_YELLOW);
                     shown_y = cy; shown_m = cm; shown_d = cd;
                 }
             }
-        } else {
+        } else if (idle_locked) {
             shown_hour = shown_min = -1;
             shown_y = shown_m = shown_d = -1;
+            shown_status = -1;
         }
+        if (idle_locked) ui_input_unlock();
+        display_flush();
         vTaskDelayUntil(&pt_last, pdMS_TO_TICKS(100));
     }
 }
@@ -356,275 +217,20 @@ void ui_task(void *pvParam) {
 	reminders_recalc();
     buttons_init();
     ui_state = UI_IDLE;
-    TickType_t last = xTaskGetTickCount();
+    bool wake_hold = false;
     while (1) {
-        BtnEdges e = {0};
-        scan_buttons(&e);
-        switch (ui_state) {
-        case UI_IDLE: {
-            if (alarm_active && e.cancel_edge) {
-                bool is_rep = false;
-                if (reminders_mutex) xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-                if (alarm_index >= 0 && alarm_index < num_reminders) {
-                    is_rep = (strncasecmp(reminders[alarm_index].status, "repeat", 6) == 0);
-                }
-                if (reminders_mutex) xSemaphoreGive(reminders_mutex);
-                if (is_rep) {                 
-                    time_t nowt; time(&nowt);
-                    snooze_until = nowt + SNOOZE_SECS;
-                    snooze_index = alarm_index;
-                } else {
-                    snooze_index = -1;
-                }
-                alarm_active = false;
-                alarm_screen_visible = false;         
-                shown_hour = shown_min = -1;  
-                shown_y = shown_m = shown_d = -1;
-                gpio_set_level(LDR_BUZZER_PIN, 0);
-                draw_idle_screen_now();
-                time_t now; struct tm timeinfo;
-                time(&now); localtime_r(&now, &timeinfo);
-                shown_hour = timeinfo.tm_hour; shown_min = timeinfo.tm_min;
-                shown_y = timeinfo.tm_year+1900; shown_m = timeinfo.tm_mon+1; shown_d = timeinfo.tm_mday;
-                idle_draw_upcoming(&timeinfo);
-                xEventGroupSetBits(eg_alarm, EV_GESTURE_DONE);   
-                ldr_gl5537_set_enabled(&ldr, false);
-                break;                        
-            }
-            if (e.ok_edge) {
-                if (alarm_active) {                    
-                    alarm_active = false;  
-                    alarm_screen_visible = false;           
-                    shown_hour = shown_min = -1;       
-                    shown_y = shown_m = shown_d = -1;
-                    gpio_set_level(LDR_BUZZER_PIN, 0);
-                    draw_idle_screen_now();
-                    time_t now; struct tm timeinfo;
-                    time(&now); localtime_r(&now, &timeinfo);
-                    shown_hour = timeinfo.tm_hour; shown_min = timeinfo.tm_min;
-                    shown_y = timeinfo.tm_year+1900; shown_m = timeinfo.tm_mon+1; shown_d = timeinfo.tm_mday;
-                    idle_draw_upcoming(&timeinfo);
-                    xEventGroupSetBits(eg_alarm, EV_GESTURE_DONE);   
-                    ldr_gl5537_set_enabled(&ldr, false);
-                }
-                menu_index = 0;
-                SET_STATE(UI_MENU);
-                ui_draw_menu();
-            }
-            break;
-        }
-        break;
-        case UI_MENU:
-            if (e.next_edge) { if (menu_index>0) menu_index--; else menu_index=3; ui_draw_menu(); }
-            if (e.back_edge) { if (menu_index<3) menu_index++; else menu_index=0; ui_draw_menu(); }
-            if (e.ok_edge) {
-                if (menu_index == 0) { 
-                    if (num_reminders==0) { SET_STATE(UI_IDLE); shown_hour=shown_min=-1; break; }
-                    pick_index=0; SET_STATE(UI_VIEW_LIST); ui_draw_list_content("DANH SACH LICH");
-                } else if (menu_index == 1) { 
-                    if (num_reminders==0) { SET_STATE(UI_IDLE); shown_hour=shown_min=-1; break; }
-                    pick_index=0; SET_STATE(UI_EDIT_PICK); ui_draw_list_content("CHON LICH CAN CHINH");
-                } else if (menu_index == 2) { 
-                    preset_index=0; two_sel=SEL_LEFT; edit_active=false;
-                    time_t now; struct tm t; time(&now); localtime_r(&now,&t);
-                    edit_year = t.tm_year + 1900;
-                    SET_STATE(UI_ADD_CONTENT); ui_draw_preset_list("CHON NOI DUNG");
-                } else { 
-                    if (num_reminders==0) { SET_STATE(UI_IDLE); shown_hour=shown_min=-1; break; }
-                    pick_index=0; SET_STATE(UI_DEL_PICK); ui_draw_list_content("XOA LICH");
-                }
-            }
-            if (e.cancel_edge) { 
-                alarm_active = false; 
-                alarm_screen_visible = false;                     
-                SET_STATE(UI_IDLE); 
-                shown_hour=shown_min=-1; 
-                shown_y = shown_m = shown_d = -1; 
-                xEventGroupSetBits(eg_alarm, EV_GESTURE_DONE);  
-                ldr_gl5537_set_enabled(&ldr, false);         
-            }
-            break;   
-        case UI_VIEW_LIST:
-            if (e.next_edge) { if (pick_index>0) pick_index--; else pick_index=(num_reminders>0?num_reminders-1:0); ui_draw_list_content("DANH SACH LICH"); }
-            if (e.back_edge) { if (pick_index<num_reminders-1) pick_index++; else pick_index=0; ui_draw_list_content("DANH SACH LICH"); }
-            if (e.ok_edge)   { SET_STATE(UI_VIEW_DETAIL); ui_draw_view_detail(); }
-            if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
-            break;
-        case UI_VIEW_DETAIL:
-            if (e.ok_edge || e.cancel_edge) {
-                SET_STATE(UI_VIEW_LIST);
-                ui_draw_list_content("DANH SACH LICH");
-            }
-            break;
-        case UI_EDIT_PICK:
-            if (e.next_edge) { if (pick_index>0) pick_index--; else pick_index=(num_reminders>0?num_reminders-1:0); ui_draw_list_content("CHON LICH CAN CHINH"); }
-            if (e.back_edge) { if (pick_index<num_reminders-1) pick_index++; else pick_index=0; ui_draw_list_content("CHON LICH CAN CHINH"); }
-            if (e.ok_edge) {
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-                edit_hour  = reminders[pick_index].hour;
-                edit_min   = reminders[pick_index].minute;
-                parse_date(reminders[pick_index].date, &edit_year, &edit_month, &edit_day);
-                xSemaphoreGive(reminders_mutex);
-                submenu_index = 0; edit_active=false; two_sel=SEL_LEFT;
-                SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
-            }
-            if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
-            break;
-        case UI_EDIT_SUBMENU:
-            if (e.next_edge) { if (submenu_index>0) submenu_index--; else submenu_index=2; ui_draw_edit_submenu(); }
-            if (e.back_edge) { if (submenu_index<2) submenu_index++; else submenu_index=0; ui_draw_edit_submenu(); }
-            if (e.ok_edge) {
-                if (submenu_index==0) { 
-                    preset_index=0;
-                    SET_STATE(UI_EDIT_CONTENT); ui_draw_preset_list("CHON NOI DUNG MOI");
-                } else if (submenu_index==1) { 
-                    two_sel=SEL_LEFT; edit_active=false;
-                    SET_STATE(UI_EDIT_DATE); ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
-                } else { 
-                    field_sel=SEL_HOUR; edit_active=false;
-                    SET_STATE(UI_EDIT_TIME); ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
-                }
-            }
-            if (e.cancel_edge){ SET_STATE(UI_EDIT_PICK); ui_draw_list_content("CHON LICH CAN CHINH"); }
-            break;
-        case UI_EDIT_CONTENT:
-            if (e.next_edge) { if (preset_index>0) preset_index--; else preset_index=NUM_CONTENT_PRESETS-1; ui_draw_preset_list("CHON NOI DUNG MOI"); }
-            if (e.back_edge) { if (preset_index<NUM_CONTENT_PRESETS-1) preset_index++; else preset_index=0; ui_draw_preset_list("CHON NOI DUNG MOI"); }
-            if (e.ok_edge) {
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-		        strncpy(reminders[pick_index].content, CONTENT_PRESETS[preset_index], sizeof(reminders[pick_index].content)-1);
-		        reminders[pick_index].content[sizeof(reminders[pick_index].content)-1] = 0;
-		        xSemaphoreGive(reminders_mutex);
-		        update_reminder(reminders[pick_index].id, reminders[pick_index].date, reminders[pick_index].hour, reminders[pick_index].minute, reminders[pick_index].content, reminders[pick_index].status);
-		        save_reminders_to_nvs();
-                SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
-            }
-            if (e.cancel_edge){ SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu(); }
-            break;
-        case UI_EDIT_DATE:
-            if (e.next_edge) {
-                if (!edit_active) { two_sel = (two_sel==SEL_LEFT)?SEL_RIGHT:SEL_LEFT; }
-                else { if (two_sel==SEL_LEFT) { edit_day++; } else { edit_month++; } clamp_day_month_y(&edit_day,&edit_month,edit_year); }
-                ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
-            }
-            if (e.back_edge) {
-                if (!edit_active) { two_sel = (two_sel==SEL_LEFT)?SEL_RIGHT:SEL_LEFT; }
-                else { if (two_sel==SEL_LEFT) { edit_day--; } else { edit_month--; } clamp_day_month_y(&edit_day,&edit_month,edit_year); }
-                ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
-            }
-            if (e.ok_edge) {
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-		        fmt_date(edit_year, edit_month, edit_day, reminders[pick_index].date);
-		        xSemaphoreGive(reminders_mutex);
-		        update_reminder(reminders[pick_index].id, reminders[pick_index].date, reminders[pick_index].hour, reminders[pick_index].minute, reminders[pick_index].content, reminders[pick_index].status);
-		        edit_active = !edit_active; 
-                save_reminders_to_nvs();
-		        ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
-             }
-            if (e.cancel_edge) {
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-                fmt_date(edit_year, edit_month, edit_day, reminders[pick_index].date);
-                xSemaphoreGive(reminders_mutex);
-                SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
-            }
-            break;
-        case UI_EDIT_TIME:
-            if (e.next_edge) {
-                if (!edit_active) { field_sel=(field_sel==SEL_HOUR)?SEL_MINUTE:SEL_HOUR; }
-                else { if (field_sel==SEL_HOUR) edit_hour++; else edit_min++; clamp_time(&edit_hour,&edit_min); }
-                ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
-            }
-            if (e.back_edge) {
-                if (!edit_active) { field_sel=(field_sel==SEL_HOUR)?SEL_MINUTE:SEL_HOUR; }
-                else { if (field_sel==SEL_HOUR) edit_hour--; else edit_min--; clamp_time(&edit_hour,&edit_min); }
-                ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
-            }
-            if (e.ok_edge) {
-                if (edit_active) {
-                    xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-		            if (field_sel==SEL_HOUR) reminders[pick_index].hour=edit_hour; else reminders[pick_index].minute=edit_min;
-		            xSemaphoreGive(reminders_mutex);
-		            update_reminder(reminders[pick_index].id, reminders[pick_index].date, reminders[pick_index].hour, reminders[pick_index].minute, reminders[pick_index].content, reminders[pick_index].status);
-                    save_reminders_to_nvs();
-                }
-                edit_active=!edit_active;
-                ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
-            }
-            if (e.cancel_edge) {
-                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-                reminders[pick_index].hour=edit_hour; reminders[pick_index].minute=edit_min;
-                
-                xSemaphoreGive(reminders_mutex);
-                SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
-            }
-            break;
-        case UI_ADD_CONTENT:
-            if (e.next_edge) { if (preset_index>0) preset_index--; else preset_index=NUM_CONTENT_PRESETS-1; ui_draw_preset_list("CHON NOI DUNG"); }
-            if (e.back_edge) { if (preset_index<NUM_CONTENT_PRESETS-1) preset_index++; else preset_index=0; ui_draw_preset_list("CHON NOI DUNG"); }
-            if (e.ok_edge) {
-                edit_day=1; edit_month=1; two_sel=SEL_LEFT; edit_active=false;
-                SET_STATE(UI_ADD_DATE); ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
-            }
-            if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
-            break;
-        case UI_ADD_DATE:
-            if (e.next_edge) {
-                if (two_sel==SEL_LEFT) { edit_day++; } else { edit_month++; }
-                clamp_day_month_y(&edit_day,&edit_month,edit_year);
-                ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
-            }
-            if (e.back_edge) {
-                if (two_sel==SEL_LEFT) { edit_day--; } else { edit_month--; }
-                clamp_day_month_y(&edit_day,&edit_month,edit_year);
-                ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
-            }
-            if (e.ok_edge) {
-                if (two_sel==SEL_LEFT) {
-                    two_sel = SEL_RIGHT; 
-                    ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
-                } else {
-                    field_sel = SEL_HOUR; edit_hour=0; edit_min=0;
-                    SET_STATE(UI_ADD_TIME); ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
-                }
-            }
-            if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
-            break;
-        case UI_ADD_TIME:
-            if (e.next_edge) {
-                if (field_sel==SEL_HOUR) { edit_hour++; } else { edit_min++; }
-                clamp_time(&edit_hour,&edit_min);
-                ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
-            }
-            if (e.back_edge) {
-                if (field_sel==SEL_HOUR) { edit_hour--; } else { edit_min--; }
-                clamp_time(&edit_hour,&edit_min);
-                ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
-            }
-            if (e.ok_edge) {
-                if (field_sel==SEL_HOUR) {
-                field_sel=SEL_MINUTE; 
-                ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
-                } else {
-                    char new_date[11]; fmt_date(edit_year, edit_month, edit_day, new_date);
-					add_reminder_full(next_id, new_date, edit_hour, edit_min, CONTENT_PRESETS[preset_index], "pending");
-                    save_reminders_to_nvs();
-                    SET_STATE(UI_MENU); ui_draw_menu();
-                }
-            }
-            if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
-            break;
-        case UI_DEL_PICK:
-            if (e.next_edge) { if (pick_index>0) pick_index--; else pick_index=(num_reminders>0?num_reminders-1:0); ui_draw_list_content("XOA LICH"); }
-            if (e.back_edge) { if (pick_index<num_reminders-1) pick_index++; else pick_index=0; ui_draw_list_content("XOA LICH"); }
-            if (e.ok_edge) {
-                delete_reminder_at(pick_index);
-                save_reminders_to_nvs();
-                if (num_reminders==0) { SET_STATE(UI_MENU); ui_draw_menu(); }
-                else { if (pick_index>=num_reminders) pick_index=num_reminders-1; ui_draw_list_content("XOA LICH"); }
-            }
-            if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
-            break;
-        }
-        vTaskDelayUntil(&last, pdMS_TO_TICKS(20));
+        BtnEdges e;
+        if (!buttons_wait(&e, portMAX_DELAY)) continue;
+        // Phím đầu tiên khi màn hình đang ngủ chỉ dùng để đánh thức, kể cả các lần lặp khi còn giữ
+        if (display_power_activity()) { wake_hold = true; continue; }
+        if (wake_hold && e.repeat) continue;
+        wake_hold = false;
+        // Đang phát lại bản ghi thì bỏ phím thật để kết quả không bị lẫn
+        if (input_log_replaying()) continue;
+        input_log_record(&e);
+        ui_input_lock();
+        ui_handle_input(&e);
+        ui_input_unlock();
+        display_flush();
     }
 }
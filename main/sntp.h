@@ -30,5 +30,6 @@ void time_sync_notification_cb(struct timeval *tv);
 void initialize_sntp(void);
 void obtain_time(void);
 void print_time_task(void *pvParam);
+void idle_screen_invalidate(void);
 esp_err_t save_reminders_to_nvs(void);
 esp_err_t load_reminders_from_nvs(void);
\ No newline at end of file
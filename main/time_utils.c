@@ -1,4 +1,5 @@
 #include "display.h"
+#include "civil_time.h"
 
 int clock_x = 0, clock_y = 0;
 
@@ -25,10 +26,8 @@ void fmt_date(int y, int m, int d, char out[11]) {
     out[10]=0;
 }
 
-void parse_date(const char* s, int* y, int* m, int* d) {
-    *y = (s[0]-'0')*1000 + (s[1]-'0')*100 + (s[2]-'0')*10 + (s[3]-'0');
-    *m = (s[5]-'0')*10 + (s[6]-'0');
-    *d = (s[8]-'0')*10 + (s[9]-'0');
+bool parse_date(const char* s, int* y, int* m, int* d) {
+    return civil_parse_date(s, y, m, d);
 }
 
 void clock_draw_full(int h, int m) {
@@ -50,21 +49,13 @@ void clock_draw_minutes(int m) {
     draw_string(x, clock_y, mm, COLOR_WHITE);
 }
 
-static inline int days_in_month(int year, int month) {
-    static const int dm[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
-    int d = dm[(month-1+12)%12];
-    int leap = ((year%4==0) && (year%100!=0)) || (year%400==0);
-    if (month == 2 && leap) d = 29;
-    return d;
-}
-
 void clamp_day_month_y(int* day, int* month, int year) {
     if (*month < 1) {
         *month = 12;
     } else if (*month > 12) {
         *month = 1;
     }
-    int maxd = days_in_month(year, *month);
+    int maxd = civil_days_in_month(year, *month);
     if (*day < 1) {
         *day = maxd;
     } else if (*day > maxd) {
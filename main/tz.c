@@ -0,0 +1,229 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "sdkconfig.h"
+#include "civil_time.h"
+#include "tz.h"
+
+#define TAG "TZ"
+
+typedef enum { RULE_MONTH, RULE_JULIAN1, RULE_JULIAN0 } RuleKind;
+
+typedef struct {
+    RuleKind kind;
+    int      month, week, wday, day;
+    int32_t  secs;
+} TzRule;
+
+typedef struct {
+    char     spec[TZ_SPEC_MAX];
+    int32_t  std_off, dst_off;
+    bool     has_dst;
+    TzRule   start, end;
+} TzSpec;
+
+static TzSpec cur = { .spec = "ICT-7", .std_off = 7 * 3600, .dst_off = 7 * 3600 };
+static TzTransition tr[TZ_MAX_TRANSITIONS];
+static int tr_n = 0;
+static time_t cache_lo = 1, cache_hi = 0;
+static int32_t cache_off = 7 * 3600;
+static volatile uint32_t generation = 0;
+static SemaphoreHandle_t tz_mutex = NULL;
+
+static const char *parse_name(const char *p) {
+    const char *s = p;
+    if (*p == '<') {
+        while (*p && *p != '>') p++;
+        return (*p == '>' && p - s >= 4) ? p + 1 : NULL;
+    }
+    while (isalpha((unsigned char)*p)) p++;
+    return (p - s >= 3) ? p : NULL;
+}
+
+static const char *parse_num(const char *p, int *out, int max) {
+    if (!isdigit((unsigned char)*p)) return NULL;
+    int v = 0;
+    while (isdigit((unsigned char)*p)) {
+        v = v*10 + (*p++ - '0');
+        if (v > max) return NULL;
+    }
+    *out = v;
+    return p;
+}
+
+static const char *parse_hms(const char *p, int32_t *out, int max_h) {
+    int sign = 1, h = 0, m = 0, s = 0;
+    if (*p == '+' || *p == '-') sign = (*p++ == '-') ? -1 : 1;
+    if (!(p = parse_num(p, &h, max_h))) return NULL;
+    if (*p == ':') { if (!(p = parse_num(p + 1, &m, 59))) return NULL; }
+    if (*p == ':') { if (!(p = parse_num(p + 1, &s, 59))) return NULL; }
+    *out = sign * (h*3600 + m*60 + s);
+    return p;
+}
+
+static const char *parse_rule(const char *p, TzRule *r) {
+    r->secs = 2 * 3600;
+    if (*p == 'M') {
+        r->kind = RULE_MONTH;
+        if (!(p = parse_num(p + 1, &r->month, 12)) || r->month < 1 || *p++ != '.') return NULL;
+        if (!(p = parse_num(p, &r->week, 5)) || r->week < 1 || *p++ != '.') return NULL;
+        if (!(p = parse_num(p, &r->wday, 6))) return NULL;
+    } else if (*p == 'J') {
+        r->kind = RULE_JULIAN1;
+        if (!(p = parse_num(p + 1, &r->day, 365)) || r->day < 1) return NULL;
+    } else {
+        r->kind = RULE_JULIAN0;
+        if (!(p = parse_num(p, &r->day, 365))) return NULL;
+    }
+    if (*p == '/' && !(p = parse_hms(p + 1, &r->secs, 167))) return NULL;
+    return p;
+}
+
+static bool parse_spec(const char *spec, TzSpec *out) {
+    memset(out, 0, sizeof(*out));
+    if (!spec || strlen(spec) >= TZ_SPEC_MAX) return false;
+    strcpy(out->spec, spec);
+    const char *p = parse_name(spec);
+    if (!p || !(p = parse_hms(p, &out->std_off, 24))) return false;
+    out->std_off = -out->std_off;
+    out->dst_off = out->std_off;
+    if (*p == '\0') return true;
+    if (!(p = parse_name(p))) return false;
+    out->has_dst = true;
+    out->dst_off = out->std_off + 3600;
+    if (*p && *p != ',') {
+        if (!(p = parse_hms(p, &out->dst_off, 24))) return false;
+        out->dst_off = -out->dst_off;
+    }
+    if (*p == '\0') p = ",M3.2.0,M11.1.0";
+    if (*p++ != ',' || !(p = parse_rule(p, &out->start))) return false;
+    if (*p++ != ',' || !(p = parse_rule(p, &out->end))) return false;
+    return *p == '\0';
+}
+
+static int32_t rule_day(const TzRule *r, int y) {
+    int32_t jan1 = days_from_civil(y, 1, 1);
+    switch (r->kind) {
+    case RULE_JULIAN1:
+        return jan1 + r->day - 1 + (civil_is_leap(y) && r->day >= 60);
+    case RULE_JULIAN0:
+        return jan1 + r->day;
+    default: {
+        int32_t first = days_from_civil(y, r->month, 1);
+        int wd1 = (int)((first % 7 + 11) % 7);
+        int32_t d = first + (r->wday - wd1 + 7) % 7 + (r->week - 1) * 7;
+        while (d >= first + civil_days_in_month(y, r->month)) d -= 7;
+        return d;
+    }
+    }
+}
+
+static int tr_cmp(const void *a, const void *b) {
+    const TzTransition *x = a, *y = b;
+    if (x->at != y->at) return (x->at > y->at) - (x->at < y->at);
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static void build_table(int year) {
+    tr_n = 0;
+    for (int y = year - 1; y <= year + 1; y++) {
+        tr[tr_n].at     = (time_t)rule_day(&cur.start, y) * 86400 + cur.start.secs - cur.std_off;
+        tr[tr_n].offset = cur.dst_off;
+        tr_n++;
+        tr[tr_n].at     = (time_t)rule_day(&cur.end, y) * 86400 + cur.end.secs - cur.dst_off;
+        tr[tr_n].offset = cur.std_off;
+        tr_n++;
+    }
+    qsort(tr, tr_n, sizeof(tr[0]), tr_cmp);
+}
+
+static int32_t lookup_locked(time_t t) {
+    if (t >= cache_lo && t < cache_hi) return cache_off;
+    if (!cur.has_dst) {
+        cache_lo = INT64_MIN; cache_hi = INT64_MAX; cache_off = cur.std_off;
+        return cache_off;
+    }
+    if (tr_n == 0 || t < tr[0].at || t >= tr[tr_n-1].at) {
+        struct tm tm;
+        civil_localtime(t, cur.std_off, &tm);
+        build_table(tm.tm_year + 1900);
+    }
+    int i = 0;
+    while (i + 1 < tr_n && tr[i+1].at <= t) i++;
+    cache_lo  = tr[i].at;
+    cache_hi  = tr[i+1].at;
+    cache_off = tr[i].offset;
+    return cache_off;
+}
+
+int32_t tz_offset_at(time_t t) {
+    if (!tz_mutex) return lookup_locked(t);
+    xSemaphoreTake(tz_mutex, portMAX_DELAY);
+    int32_t off = lookup_locked(t);
+    xSemaphoreGive(tz_mutex);
+    return off;
+}
+
+time_t tz_mktime(int y, int m, int d, int hh, int mm, int ss) {
+    time_t local = civil_mktime(y, m, d, hh, mm, ss, 0);
+    int32_t off = tz_offset_at(local - cur.std_off);
+    return local - off;
+}
+
+uint32_t tz_generation(void) {
+    return generation;
+}
+
+void tz_get(char *out, size_t len) {
+    if (!out || len == 0) return;
+    if (tz_mutex) xSemaphoreTake(tz_mutex, portMAX_DELAY);
+    strncpy(out, cur.spec, len - 1);
+    out[len - 1] = '\0';
+    if (tz_mutex) xSemaphoreGive(tz_mutex);
+}
+
+static void save_spec(const char *spec) {
+    nvs_handle_t h;
+    esp_err_t err = nvs_open("settings", NVS_READWRITE, &h);
+    if (err != ESP_OK) { ESP_LOGE(TAG, "NVS open fail: %s", esp_err_to_name(err)); return; }
+    err = nvs_set_str(h, "tz", spec);
+    if (err == ESP_OK) err = nvs_commit(h);
+    nvs_close(h);
+    if (err != ESP_OK) ESP_LOGE(TAG, "Lưu múi giờ lỗi: %s", esp_err_to_name(err));
+}
+
+bool tz_set(const char *spec, bool persist) {
+    TzSpec parsed;
+    if (!parse_spec(spec, &parsed)) {
+        ESP_LOGE(TAG, "Chuỗi TZ không hợp lệ: %s", spec ? spec : "null");
+        return false;
+    }
+    if (tz_mutex) xSemaphoreTake(tz_mutex, portMAX_DELAY);
+    cur = parsed;
+    tr_n = 0;
+    cache_lo = 1; cache_hi = 0;
+    generation++;
+    if (tz_mutex) xSemaphoreGive(tz_mutex);
+    setenv("TZ", parsed.spec, 1);
+    tzset();
+    if (persist) save_spec(parsed.spec);
+    ESP_LOGI(TAG, "Múi giờ: %s (UTC%+ld, DST %s)", parsed.spec,
+             (long)(parsed.std_off / 3600), parsed.has_dst ? "có" : "không");
+    return true;
+}
+
+void tz_init(void) {
+    if (!tz_mutex) tz_mutex = xSemaphoreCreateMutex();
+    char spec[TZ_SPEC_MAX] = CONFIG_REMINDER_TZ;
+    nvs_handle_t h;
+    if (nvs_open("settings", NVS_READONLY, &h) == ESP_OK) {
+        size_t len = sizeof(spec);
+        if (nvs_get_str(h, "tz", spec, &len) != ESP_OK) strcpy(spec, CONFIG_REMINDER_TZ);
+        nvs_close(h);
+    }
+    if (!tz_set(spec, false)) tz_set(CONFIG_REMINDER_TZ, false);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "esp_err.h"
+
+#define TZ_SPEC_MAX        48
+#define TZ_MAX_TRANSITIONS 6
+
+typedef struct {
+    time_t  at;
+    int32_t offset;
+} TzTransition;
+
+void     tz_init(void);
+bool     tz_set(const char *spec, bool persist);
+void     tz_get(char *out, size_t len);
+int32_t  tz_offset_at(time_t t);
+time_t   tz_mktime(int y, int m, int d, int hh, int mm, int ss);
+uint32_t tz_generation(void);
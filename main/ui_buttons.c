@@ -1,67 +1,146 @@
-#define BTN_OK_PIN     7
-#define BTN_BACK_PIN   16
-#define BTN_NEXT_PIN   15
-#define BTN_CANCEL_PIN 6
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "esp_err.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "ui_buttons.h"
+#include "ui_perf.h"
+
+#define TAG "Buttons"
+
+#define BTN_COUNT          4
+#define BTN_DEBOUNCE_MS    10
+#define BTN_EVENT_QUEUE    8
+#define BTN_TASK_STACK     2560
+#define BTN_TASK_PRIORITY  9
+
+typedef enum { BTN_OK = 0, BTN_BACK, BTN_NEXT, BTN_CANCEL } BtnId;
+
+typedef struct {
+    uint8_t btn;
+    uint16_t repeat;
+} BtnEvent;
 
 typedef struct {
     gpio_num_t pin;
-    int stable;    
-    int last_raw;  
+    bool repeats;
+    int stable;
+    bool settling;
     TickType_t tstamp;
+    TickType_t next_repeat;
+    uint32_t interval_ms;
+    uint16_t repeat;
 } DebBtn;
 
-static DebBtn db_ok    = {BTN_OK_PIN, 0, 1, 0};
-static DebBtn db_back  = {BTN_BACK_PIN, 0, 1, 0};
-static DebBtn db_next  = {BTN_NEXT_PIN, 0, 1, 0};
-static DebBtn db_cancel= {BTN_CANCEL_PIN, 0, 1, 0};
+// Chỉ NEXT/BACK tự lặp khi giữ; OK và CANCEL đổi trạng thái nên chỉ tính một lần
+static DebBtn btns[BTN_COUNT] = {
+    [BTN_OK]     = { .pin = BTN_OK_PIN },
+    [BTN_BACK]   = { .pin = BTN_BACK_PIN,   .repeats = true },
+    [BTN_NEXT]   = { .pin = BTN_NEXT_PIN,   .repeats = true },
+    [BTN_CANCEL] = { .pin = BTN_CANCEL_PIN },
+};
+static TaskHandle_t btn_task = NULL;
+static QueueHandle_t btn_q = NULL;
 
-void buttons_init(void) {
-    gpio_config_t io = {
-        .pin_bit_mask = (1ULL<<BTN_OK_PIN) | (1ULL<<BTN_BACK_PIN) | (1ULL<<BTN_NEXT_PIN) | (1ULL<<BTN_CANCEL_PIN),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
-    };
-    ESP_ERROR_CHECK(gpio_config(&io));
+static TickType_t ms_ticks(uint32_t ms) {
+    TickType_t t = pdMS_TO_TICKS(ms);
+    return t ? t : 1;
+}
+
+static void IRAM_ATTR btn_isr(void *arg) {
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(btn_task, 1u << (uint32_t)(uintptr_t)arg, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
 }
 
-static inline int read_btn(gpio_num_t pin) {
-    return (gpio_get_level(pin) == 0); 
+static void emit(int i, uint16_t repeat) {
+    // Lần lặp bị bỏ nếu ui_task còn chưa xử lý xong sự kiện trước, tránh chạy quá khi đã nhả phím
+    if (repeat && uxQueueMessagesWaiting(btn_q) > 0) return;
+    BtnEvent ev = { .btn = (uint8_t)i, .repeat = repeat };
+    if (xQueueSend(btn_q, &ev, 0) == pdTRUE) perf_input_edge();
 }
 
-static int debounce_once(DebBtn *b, TickType_t now, int *rising_edge) {
-    int raw = !gpio_get_level(b->pin); 
-    *rising_edge = 0;
-    if (raw != b->last_raw) {
-        b->tstamp = now;
-        b->last_raw = raw;
-    } else {
-        if ((now - b->tstamp) >= pdMS_TO_TICKS(10)) { 
-            if (raw != b->stable) {
-                if (raw == 1) *rising_edge = 1;
+// Chờ ngắt cạnh; chỉ hẹn giờ khi có phím đang dội hoặc đang giữ để lặp, rảnh thì ngủ hẳn
+static void buttons_task(void *arg) {
+    for (;;) {
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = portMAX_DELAY;
+        for (int i = 0; i < BTN_COUNT; i++) {
+            const DebBtn *b = &btns[i];
+            TickType_t due;
+            if (b->settling) due = b->tstamp + ms_ticks(BTN_DEBOUNCE_MS);
+            else if (b->stable && b->repeats) due = b->next_repeat;
+            else continue;
+            TickType_t left = (int32_t)(due - now) > 0 ? due - now : 0;
+            if (left < wait) wait = left;
+        }
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+        now = xTaskGetTickCount();
+        for (int i = 0; i < BTN_COUNT; i++) {
+            DebBtn *b = &btns[i];
+            if (bits & (1u << i)) {
+                b->settling = true;
+                b->tstamp = now;
+            }
+            if (b->settling) {
+                if ((int32_t)(now - b->tstamp) < (int32_t)ms_ticks(BTN_DEBOUNCE_MS)) continue;
+                b->settling = false;
+                int raw = !gpio_get_level(b->pin);
+                if (raw == b->stable) continue;
                 b->stable = raw;
+                if (!raw) continue;
+                b->repeat = 0;
+                b->interval_ms = CONFIG_BUTTON_REPEAT_MS;
+                b->next_repeat = now + ms_ticks(CONFIG_BUTTON_LONG_PRESS_MS);
+                emit(i, 0);
+            } else if (b->stable && b->repeats && (int32_t)(now - b->next_repeat) >= 0) {
+                if (b->repeat < UINT16_MAX) b->repeat++;
+                emit(i, b->repeat);
+                b->next_repeat = now + ms_ticks(b->interval_ms);
+                // Mỗi lần lặp nhanh thêm 1/4 cho tới ngưỡng tối thiểu
+                b->interval_ms = b->interval_ms * 3 / 4;
+                if (b->interval_ms < CONFIG_BUTTON_REPEAT_MIN_MS) b->interval_ms = CONFIG_BUTTON_REPEAT_MIN_MS;
             }
         }
     }
-    return b->stable;
 }
 
-typedef struct {
-    int ok_edge;
-    int back_edge;
-    int next_edge;
-    int cancel_edge;
-} BtnEdges;
+void buttons_init(void) {
+    if (btn_task) return;
+    gpio_config_t io = {
+        .pin_bit_mask = (1ULL<<BTN_OK_PIN) | (1ULL<<BTN_BACK_PIN) | (1ULL<<BTN_NEXT_PIN) | (1ULL<<BTN_CANCEL_PIN),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE
+    };
+    ESP_ERROR_CHECK(gpio_config(&io));
+    btn_q = xQueueCreate(BTN_EVENT_QUEUE, sizeof(BtnEvent));
+    xTaskCreatePinnedToCore(buttons_task, "buttons", BTN_TASK_STACK, NULL, BTN_TASK_PRIORITY, &btn_task, 1);
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "Không cài được dịch vụ ngắt GPIO: %s", esp_err_to_name(err));
+        return;
+    }
+    for (int i = 0; i < BTN_COUNT; i++) {
+        btns[i].stable = !gpio_get_level(btns[i].pin);
+        gpio_isr_handler_add(btns[i].pin, btn_isr, (void *)(uintptr_t)i);
+    }
+}
 
-void scan_buttons(BtnEdges *e) {
-    TickType_t now = xTaskGetTickCount();
-    debounce_once(&db_ok, now,     &e->ok_edge);
-    debounce_once(&db_back, now,   &e->back_edge);
-    debounce_once(&db_next, now,   &e->next_edge);
-    debounce_once(&db_cancel, now, &e->cancel_edge);
+bool buttons_wait(BtnEdges *e, TickType_t timeout) {
+    BtnEvent ev;
+    *e = (BtnEdges){0};
+    if (!btn_q || xQueueReceive(btn_q, &ev, timeout) != pdTRUE) return false;
+    switch (ev.btn) {
+    case BTN_OK:     e->ok_edge = 1; break;
+    case BTN_BACK:   e->back_edge = 1; break;
+    case BTN_NEXT:   e->next_edge = 1; break;
+    case BTN_CANCEL: e->cancel_edge = 1; break;
+    }
+    e->repeat = ev.repeat;
+    return true;
 }
\ No newline at end of file
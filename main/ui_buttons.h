@@ -3,17 +3,20 @@
 #define BTN_BACK_PIN   16
 #define BTN_NEXT_PIN   15
 #define BTN_CANCEL_PIN 6
+#include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
 #include "esp_err.h"
 
+// Một sự kiện phím đã chống dội; repeat > 0 là lần lặp thứ repeat khi giữ NEXT/BACK
 typedef struct {
     int ok_edge;
     int back_edge;
     int next_edge;
     int cancel_edge;
+    int repeat;
 } BtnEdges;
 
 void buttons_init(void);
-void scan_buttons(BtnEdges *e);
+bool buttons_wait(BtnEdges *e, TickType_t timeout);
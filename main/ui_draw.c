@@ -9,6 +9,15 @@
 #include "display.h"
 #include "reminders_store.h"
 #include "time_utils.h"
+#include "clock_source.h"
+#include "upcoming.h"
+#include "calendar_index.h"
+#include "civil_time.h"
+#include "glyph.h"
+#include "icons.h"
+#include "ui_perf.h"
+#include "ui_widgets.h"
+#include "ui_fsm.h"
 
 const char* CONTENT_PRESETS[] = {
     "BAO THUC", "HOP SANG", "HOP CHIEU", "TAP THE DUC",
@@ -19,7 +28,7 @@ const char* CONTENT_PRESETS[] = {
 const int NUM_CONTENT_PRESETS = (int)(sizeof(CONTENT_PRESETS)/sizeof(CONTENT_PRESETS[0]));
 
 static bool idle_screen_inited = false;
-static int center_x(const char *s) { return (TFT_WIDTH - (int)strlen(s)*FONT_W)/2; }
+static int center_x(const char *s) { return (TFT_WIDTH - (int)utf8_glyphs(s, strlen(s))*FONT_W)/2; }
 int idle_x = 0, idle_y = 0;
 uint32_t ui_epoch = 0;
 int preset_index  = 0;  
@@ -27,131 +36,97 @@ TwoSel two_sel = SEL_LEFT;
 int menu_index = 0;           
 FieldSel field_sel = SEL_HOUR;
 int submenu_index = 0; 
+int cal_year = 2025, cal_month = 1, cal_day = 1; 
 UiState ui_state = UI_IDLE;
 
-static inline int status_rank(const char* s) {
-    if (!s) return 2;
-    if (strncmp(s, "pending", 7)  == 0) return 1;
-    if (strncmp(s, "repeat",  6)  == 0) return 0;
-    return 2;
+static const Sprite *status_icon(const char* s) {
+    if (!s) return NULL;
+    if (!strncmp(s, "pending",   7)) return &icon_bell;
+    if (!strncmp(s, "completed", 9)) return &icon_done;
+    if (!strncmp(s, "repeat",    6)) return &icon_snooze;
+    return NULL;
 }
 
-static const char* status_label(const char* s) {
-    if (!s) return "";
-    if (!strncmp(s, "pending",   7)) return "PENDING";
-    if (!strncmp(s, "completed", 9)) return "COMPLETED";
-    if (!strncmp(s, "repeat",    6)) return "REPEAT";
-    return "";
-}
-
-static inline uint16_t status_color(const char* s) {
-    if (!s) return COLOR_WHITE;
-    if (!strncmp(s, "pending",   7)) return COLOR_PENDING;
-    if (!strncmp(s, "completed", 9)) return COLOR_COMPLETED;
-    if (!strncmp(s, "repeat",    6)) return COLOR_REPEAT;
-    return COLOR_WHITE;
-}
-
-void show_alarm_feedback(const char *msg, uint16_t color) {
+void show_alarm_feedback(const char *msg, uint16_t color, const Sprite *icon) {
     if (!msg) return;
     fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
-    int x = (TFT_WIDTH  - (int)strlen(msg)*FONT_W)/2;
+    int x = (TFT_WIDTH  - (int)utf8_glyphs(msg, strlen(msg))*FONT_W)/2;
     int y = (TFT_HEIGHT - FONT_H)/2;
     if (x < 0) x = 0;
+    if (icon) draw_sprite((TFT_WIDTH - icon->w)/2, y - icon->h - 8, icon, COLOR_BLACK);
     draw_string(x, y, msg, color);
 }
 
+// Hàng biểu tượng trên cùng màn hình chờ; chỉ vẽ lại biểu tượng có trạng thái đổi, old_flags < 0 vẽ tất cả
+void idle_draw_status(int flags, int old_flags) {
+    int changed = old_flags < 0 ? -1 : (flags ^ old_flags);
+    const int wifi_x = TFT_WIDTH - 4 - icon_wifi.w;
+    const int mqtt_x = wifi_x - 4 - icon_mqtt.w;
+    if (changed & IDLE_ST_WIFI) draw_sprite(wifi_x, IDLE_STATUS_Y, (flags & IDLE_ST_WIFI) ? &icon_wifi : &icon_wifi_off, COLOR_BLACK);
+    if (changed & IDLE_ST_MQTT) draw_sprite(mqtt_x, IDLE_STATUS_Y, (flags & IDLE_ST_MQTT) ? &icon_mqtt : &icon_mqtt_off, COLOR_BLACK);
+    if (changed & IDLE_ST_SNOOZE) {
+        if (flags & IDLE_ST_SNOOZE) draw_sprite(4, IDLE_STATUS_Y, &icon_snooze, COLOR_BLACK);
+        else fill_rect(4, IDLE_STATUS_Y, icon_snooze.w, icon_snooze.h, COLOR_BLACK);
+    }
+}
+
 void idle_draw_upcoming(const struct tm* now_local) {
     if (!now_local) return;
-    const int base_y = idle_y + FONT_H + 6 + 12;  
+    const int base_y = idle_y + IDLE_DATE_DY + FONT_H + 12;
     const int line_h = 12;
-    struct tm now_tm = *now_local;
-    now_tm.tm_sec = 0;
-    time_t now_ts = mktime(&now_tm);  
-	typedef struct { int idx; int rank; int days_until; int min_in_day; } Slot;
-	Slot top[3] = { {-1,99,INT_MAX,INT_MAX}, {-1,99,INT_MAX,INT_MAX}, {-1,99,INT_MAX,INT_MAX} };
-	int now_total_min = now_local->tm_hour*60 + now_local->tm_min;
+    int rows = (TFT_HEIGHT - base_y) / line_h;
+    if (rows > UPCOMING_K) rows = UPCOMING_K;
+    UpcomingEntry top[UPCOMING_K];
 	xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-	for (int i = 0; i < num_reminders; i++) {
-    	const Reminder *r = &reminders[i];
-    	if (strncmp(r->status, "completed", 9) == 0) continue; 
-    	int rank = status_rank(r->status); 
-    	int days_until = 0;
-    	int min_in_day = 0;
-    	if (strncmp(r->status, "repeat", 6) == 0) {
-        	int ev_total_min = r->hour*60 + r->minute;
-        	if (ev_total_min >= now_total_min) {
-            	days_until = 0;
-            	min_in_day = ev_total_min - now_total_min;
-        	} else {
-            	days_until = 1;
-            	min_in_day = ev_total_min + 1440 - now_total_min;
-        	}
-    	} else {
-        	int y,m,d; parse_date(r->date, &y,&m,&d);
-        	struct tm ev = *now_local;
-        	ev.tm_year = y - 1900; ev.tm_mon = m - 1; ev.tm_mday = d;
-        	ev.tm_hour = r->hour;  ev.tm_min = r->minute; ev.tm_sec = 0;
-        	time_t now_ts = mktime((struct tm*)now_local);
-        	time_t ev_ts  = mktime(&ev);
-        	long delta_min = (long)((ev_ts - now_ts)/60);
-        	if (delta_min < 0) continue;             
-        	days_until = (int)(delta_min / 1440);    
-        	min_in_day = (int)(delta_min % 1440);   
-    	}
-    	for (int k=0; k<3; k++) {
-        	if (rank < top[k].rank ||
-        	(rank == top[k].rank && (days_until < top[k].days_until ||
-           	(days_until == top[k].days_until && min_in_day < top[k].min_in_day)))) {
-            	for (int t=2; t>k; t--) top[t] = top[t-1];
-            	top[k].idx = i; top[k].rank = rank;
-            	top[k].days_until = days_until; top[k].min_in_day = min_in_day;
-            	break;
-        	}
-    	}
-	}
+	int n = upcoming_top_locked(upcoming_local_min(now_local), top, rows);
 	xSemaphoreGive(reminders_mutex);
-	fill_rect(0, base_y - 2, TFT_WIDTH, line_h*3 + 4, COLOR_BLACK);
-	for (int row = 0; row < 3; row++) {
+	fill_rect(0, base_y - 2, TFT_WIDTH, line_h*rows + 2, COLOR_BLACK);
+	for (int row = 0; row < n; row++) {
     	int y = base_y + row * line_h;
-    	if (top[row].idx < 0) continue;
-    	Reminder r;
-    	xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-    	r = reminders[top[row].idx];
-    	xSemaphoreGive(reminders_mutex);
+    	const Reminder r = top[row].r;
     	char hhmm[6]; fmt_time(r.hour, r.minute, hhmm);
-    	const char* st = status_label(r.status);
-    	char st_bracket[16]; snprintf(st_bracket, sizeof(st_bracket), "[%s]", st);
-    	int status_len = (int)strlen(st_bracket);
-    	int max_chars     = TFT_WIDTH / FONT_W;   
+    	const Sprite *icon = status_icon(r.status);
+    	int max_chars     = (TFT_WIDTH - 4 - (icon ? icon->w + 8 : 0)) / FONT_W;
     	int fixed_prefix  = 6;                    
-    	int avail_content = max_chars - fixed_prefix - 1 - status_len;
+    	int avail_content = max_chars - fixed_prefix;
     	if (avail_content < 0) avail_content = 0;
-    	char content_cut[32];
-    	snprintf(content_cut, sizeof(content_cut), "%.*s", avail_content, r.content);
-    	char prefix[64];
-    	snprintf(prefix, sizeof(prefix), "%s %s ", hhmm, content_cut);
+    	char content_cut[64];
+    	snprintf(content_cut, sizeof(content_cut), "%.*s", (int)utf8_prefix(r.content, avail_content), r.content);
+    	char prefix[80];
+    	snprintf(prefix, sizeof(prefix), "%s %s", hhmm, content_cut);
     	fill_rect(0, y, TFT_WIDTH, line_h, COLOR_BLACK);
     	draw_string(4, y, prefix, COLOR_WHITE);
-    	int sx = 4 + (int)strlen(prefix) * FONT_W;
-    	draw_string(sx, y, st_bracket, status_color(r.status));
+    	if (icon) draw_sprite(TFT_WIDTH - 4 - icon->w, y - 1, icon, COLOR_BLACK);
 	}
 }
 
-void draw_idle_screen_now(void) {
-    time_t now; struct tm ti;
-    time(&now); localtime_r(&now, &ti);
+// Chỉ gửi lại các ô chữ số khác với lần vẽ trước; old_hour < 0 vẽ cả đồng hồ
+void idle_draw_clock(int hour, int min, int old_hour, int old_min) {
+    char now[6], old[6] = "";
+    fmt_time(hour, min, now);
+    if (old_hour >= 0 && old_min >= 0) fmt_time(old_hour, old_min, old);
+    for (int i = 0; i < 5; i++) {
+        if (now[i] == old[i]) continue;
+        char cell[2] = { now[i], 0 };
+        draw_big_string(idle_x + i * BIG_W, idle_y, cell, COLOR_WHITE, COLOR_BLACK);
+    }
+}
+
+void draw_idle_screen_now(const struct tm *ti, int status) {
+    PerfFrame pf = perf_frame_begin(SCR_IDLE);
     fill_screen(COLOR_BLACK);
     const char *title = "THOI GIAN HIEN TAI";
     draw_string((TFT_WIDTH - (int)strlen(title)*FONT_W)/2, 20, title, COLOR_GREEN);
-    idle_x = (TFT_WIDTH  - 5 * FONT_W)/2;   
-    idle_y = (TFT_HEIGHT - FONT_H)/2 - 6;
-    char hhmm[6]; fmt_time(ti.tm_hour, ti.tm_min, hhmm);
-    draw_string(idle_x, idle_y, hhmm, COLOR_WHITE);
+    idle_x = (TFT_WIDTH - IDLE_CLOCK_W)/2;
+    idle_y = IDLE_CLOCK_Y;
+    idle_draw_clock(ti->tm_hour, ti->tm_min, -1, -1);
     char datebuf[11];
-    fmt_date(ti.tm_year+1900, ti.tm_mon+1, ti.tm_mday, datebuf);
+    fmt_date(ti->tm_year+1900, ti->tm_mon+1, ti->tm_mday, datebuf);
     int dx = (TFT_WIDTH - (int)strlen(datebuf)*FONT_W)/2;
-    draw_string(dx, idle_y + FONT_H + 6, datebuf, COLOR_YELLOW);
+    draw_string(dx, idle_y + IDLE_DATE_DY, datebuf, COLOR_YELLOW);
+    idle_draw_status(status, -1);
+    idle_draw_upcoming(ti);
+    perf_frame_end(pf);
 }
 
 void idle_clock_screen_init(void) {
@@ -164,278 +139,213 @@ void idle_clock_screen_init(void) {
 }
 
 void ui_draw_menu(void) {
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int prev_idx = -1;
-    if (last_epoch != ui_epoch) {
-        fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
-        draw_line_text( 4, "MENU CAI DAT", COLOR_GREEN);
-        uint16_t sel = COLOR_YELLOW;
-        draw_line_text(20, (menu_index==0)? "> XEM"   : "  XEM",   (menu_index==0)? sel:COLOR_WHITE);
-        draw_line_text(32, (menu_index==1)? "> CHINH" : "  CHINH", (menu_index==1)? sel:COLOR_WHITE);
-        draw_line_text(44, (menu_index==2)? "> THEM"  : "  THEM",  (menu_index==2)? sel:COLOR_WHITE);
-        draw_line_text(56, (menu_index==3)? "> XOA"   : "  XOA",   (menu_index==3)? sel:COLOR_WHITE);
-        draw_line_text(100,"OK:CHON  NEXT:LEN", COLOR_BLUE);
-        draw_line_text(112,"BACK:XUONG  CANCEL:THOAT", COLOR_BLUE);
-        prev_idx = menu_index; last_epoch = ui_epoch; return;
-    }
-    if (prev_idx!=menu_index) {
-        uint16_t sel = COLOR_YELLOW;
-        draw_line_text(20, (menu_index==0)? "> XEM"   : "  XEM",   (menu_index==0)? sel:COLOR_WHITE);
-        draw_line_text(32, (menu_index==1)? "> CHINH" : "  CHINH", (menu_index==1)? sel:COLOR_WHITE);
-        draw_line_text(44, (menu_index==2)? "> THEM"  : "  THEM",  (menu_index==2)? sel:COLOR_WHITE);
-        draw_line_text(56, (menu_index==3)? "> XOA"   : "  XOA",   (menu_index==3)? sel:COLOR_WHITE);
-        prev_idx = menu_index;
+    static const char *const items[] = { "XEM", "CHINH", "THEM", "XOA", "LICH THANG" };
+    ui_frame_begin(SCR_MENU);
+    ui_line(4, "MENU CAI DAT", COLOR_GREEN);
+    for (int i = 0; i < 5; i++) {
+        char line[16];
+        snprintf(line, sizeof(line), "%c %s", menu_index == i ? '>' : ' ', items[i]);
+        ui_line(20 + i*12, line, menu_index == i ? COLOR_YELLOW : COLOR_WHITE);
     }
+    ui_hint(100, "OK:CHON  NEXT:LEN");
+    ui_hint(112, "BACK:XUONG  CANCEL:THOAT");
+    ui_frame_end();
 }
 
-void ui_draw_pick_list(const char *title) {
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int prev_idx = -1;
-    static int prev_base = -1;
-    int base = (pick_index/6)*6;
-    if (last_epoch != ui_epoch || base != prev_base) {
+#define LIST_Y0     20
+#define LIST_ROW_H  12
+#define LIST_ROWS   6
+
+typedef uint16_t (*ListRowFn)(int idx, bool selected, char *out, size_t n);
+
+typedef struct {
+    uint32_t epoch;
+    int sel, base, count;
+} ListView;
+
+#define LIST_VIEW_INIT { (uint32_t)-1, -1, 0, -1 }
+
+static void list_draw_row(const ListView *lv, int idx, ListRowFn fn) {
+    int row = idx - lv->base;
+    if (idx < 0 || idx >= lv->count || row < 0 || row >= LIST_ROWS) return;
+    char line[64];
+    uint16_t color = fn(idx, idx == lv->sel, line, sizeof(line));
+    draw_line_text(LIST_Y0 + row * LIST_ROW_H, line, color);
+}
+
+// Danh sách cuộn từng hàng: dịch vùng cuộn phần cứng rồi chỉ vẽ các hàng mới lộ ra
+static void list_view_draw(ListView *lv, int screen, const char *title, int sel, int count, ListRowFn fn,
+                           SemaphoreHandle_t lock, const char *const *hints, int n_hints) {
+    PerfFrame pf = perf_frame_begin(screen);
+    int base = lv->base;
+    if (sel < base) base = sel;
+    if (sel >= base + LIST_ROWS) base = sel - LIST_ROWS + 1;
+    if (base > count - LIST_ROWS) base = count - LIST_ROWS;
+    if (base < 0) base = 0;
+    int shift = base - lv->base;
+    int prev_sel = lv->sel;
+    bool full = lv->epoch != ui_epoch || lv->count != count || shift >= LIST_ROWS || shift <= -LIST_ROWS;
+    lv->base = base;
+    lv->sel = sel;
+    lv->count = count;
+    if (lock) xSemaphoreTake(lock, portMAX_DELAY);
+    if (full) {
         fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
-        draw_line_text(4, title, COLOR_GREEN);
-        xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-        for (int i=0; i<6 && (base+i)<num_reminders; i++) {
-            char tt[6], buf[16];
-            fmt_time(reminders[base+i].hour, reminders[base+i].minute, tt);
-            snprintf(buf, sizeof(buf), "%c %s", (base+i)==pick_index?'>':' ', tt);
-            draw_line_text(20 + i*12, buf, ((base+i)==pick_index)? COLOR_GREEN : COLOR_WHITE);
-        }
-        xSemaphoreGive(reminders_mutex);
-        draw_line_text(100, "OK:CHON  NEXT:LEN", COLOR_BLUE);
-        draw_line_text(112, "BACK:XUONG", COLOR_BLUE);
-        draw_line_text(124, "CANCEL:THOAT", COLOR_BLUE);
-        prev_idx = pick_index;
-        prev_base = base;
-        last_epoch = ui_epoch;
-        return;
-    }
-    if (prev_idx != pick_index) {
-        int old_row = prev_idx - base;
-        int new_row = pick_index - base;
-        if (old_row >=0 && old_row < 6) {
-            char tt[6], buf[16];
-            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-            fmt_time(reminders[prev_idx].hour, reminders[prev_idx].minute, tt);
-            xSemaphoreGive(reminders_mutex);
-            snprintf(buf, sizeof(buf), "  %s", tt);
-            draw_line_text(20 + old_row*12, buf, COLOR_WHITE);
+        display_scroll_area(LIST_Y0, LIST_ROWS * LIST_ROW_H);
+        draw_strip(4, title, COLOR_GREEN, COLOR_BLACK);
+        for (int i = 0; i < LIST_ROWS; i++) list_draw_row(lv, base + i, fn);
+        for (int i = 0; i < n_hints; i++) draw_strip(100 + i * 12, hints[i], COLOR_BLUE, COLOR_BLACK);
+        lv->epoch = ui_epoch;
+    } else {
+        if (shift) {
+            display_scroll(shift * LIST_ROW_H);
+            int from = shift > 0 ? base + LIST_ROWS - shift : base;
+            int n = shift > 0 ? shift : -shift;
+            for (int i = 0; i < n; i++) list_draw_row(lv, from + i, fn);
         }
-        if (new_row >=0 && new_row < 6) {
-            char tt[6], buf[16];
-            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-            fmt_time(reminders[pick_index].hour, reminders[pick_index].minute, tt);
-            xSemaphoreGive(reminders_mutex);
-            snprintf(buf, sizeof(buf), "> %s", tt);
-            draw_line_text(20 + new_row*12, buf, COLOR_GREEN);
+        if (prev_sel != sel) {
+            list_draw_row(lv, prev_sel, fn);
+            list_draw_row(lv, sel, fn);
         }
-        prev_idx = pick_index;
     }
+    if (lock) xSemaphoreGive(lock);
+    perf_frame_end(pf);
+}
+
+static uint16_t pick_row(int idx, bool selected, char *out, size_t n) {
+    char tt[6];
+    fmt_time(reminders[idx].hour, reminders[idx].minute, tt);
+    snprintf(out, n, "%c %s", selected ? '>' : ' ', tt);
+    return selected ? COLOR_GREEN : COLOR_WHITE;
+}
+
+static uint16_t content_row(int idx, bool selected, char *out, size_t n) {
+    const char *content = reminders[idx].content;
+    snprintf(out, n, "%c %.*s", selected ? '>' : ' ', (int)utf8_prefix(content, 16), content);
+    return selected ? COLOR_YELLOW : COLOR_WHITE;
+}
+
+static uint16_t preset_row(int idx, bool selected, char *out, size_t n) {
+    snprintf(out, n, "%c %.16s", selected ? '>' : ' ', CONTENT_PRESETS[idx]);
+    return selected ? COLOR_YELLOW : COLOR_WHITE;
+}
+
+void ui_draw_pick_list(const char *title) {
+    static ListView lv = LIST_VIEW_INIT;
+    static const char *const hints[] = { "OK:CHON  NEXT:LEN", "BACK:XUONG", "CANCEL:THOAT" };
+    list_view_draw(&lv, SCR_PICK_LIST, title, pick_index, num_reminders, pick_row, reminders_mutex, hints, 3);
 }
 
 void ui_draw_time_editor(const char *title, int h, int m, FieldSel sel, bool show_hint_cancel_save) {
-    const int FW = FONT_W, FH = FONT_H;
-    const int X0 = (TFT_WIDTH - 5*FW)/2;
+    const int X0 = (TFT_WIDTH - 5*FONT_W)/2;
     const int Y0 = 60;
-    const int HOUR_X = X0, MIN_X = X0 + 3*FW;
-    const int HOUR_W = 2*FW, MIN_W = 2*FW;
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int  prev_h = -1, prev_m = -1;
-    static FieldSel prev_sel = SEL_HOUR;
-    static bool prev_hint = false;
-    static char prev_title[24] = {0};
-    if (last_epoch != ui_epoch || strcmp(prev_title, title)!=0 || prev_hint != show_hint_cancel_save) {
-        fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
-        draw_line_text(4, title, COLOR_GREEN);
-        draw_line_text(96, "NEXT/BACK:+/-", COLOR_BLUE);
-        draw_line_text(108,"OK:LUU TRUONG",  COLOR_BLUE);
-        draw_line_text(120, show_hint_cancel_save ? "CANCEL:LUU & THOAT" : "CANCEL:THOAT", COLOR_BLUE);
-        draw_string(X0 + 2*FW, Y0, ":", COLOR_WHITE);
-        prev_h = -1; prev_m = -1; prev_sel = sel;
-        strncpy(prev_title, title, sizeof(prev_title)-1);
-        prev_hint = show_hint_cancel_save;
-        last_epoch = ui_epoch;
-    }
-
-    uint16_t colH = (sel==SEL_HOUR)   ? COLOR_GREEN : COLOR_WHITE;
-    uint16_t colM = (sel==SEL_MINUTE) ? COLOR_GREEN : COLOR_WHITE;
-    if (h != prev_h || sel != prev_sel) {
-        fill_rect(HOUR_X, Y0, HOUR_W, FH, COLOR_BLACK);
-        char hh[3] = { (char)('0'+(h/10)), (char)('0'+(h%10)), 0 };
-        draw_string(HOUR_X, Y0, hh, colH);
-        prev_h = h;
-    }
-    if (m != prev_m || sel != prev_sel) {
-        fill_rect(MIN_X, Y0, MIN_W, FH, COLOR_BLACK);
-        char mm[3] = { (char)('0'+(m/10)), (char)('0'+(m%10)), 0 };
-        draw_string(MIN_X, Y0, mm, colM);
-        prev_m = m;
-    }
-    prev_sel = sel;
+    ui_frame_begin(SCR_TIME_EDIT);
+    ui_line(4, title, COLOR_GREEN);
+    ui_field(X0, Y0, h, 2, (sel==SEL_HOUR) ? COLOR_GREEN : COLOR_WHITE);
+    ui_label(X0 + 2*FONT_W, Y0, ":", COLOR_WHITE);
+    ui_field(X0 + 3*FONT_W, Y0, m, 2, (sel==SEL_MINUTE) ? COLOR_GREEN : COLOR_WHITE);
+    ui_hint(96, "NEXT/BACK:+/-");
+    ui_hint(108, "OK:LUU TRUONG");
+    ui_hint(120, show_hint_cancel_save ? "CANCEL:LUU & THOAT" : "CANCEL:THOAT");
+    ui_frame_end();
 }
 
 void ui_draw_list_content(const char *title) {
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int prev_idx = -1;
-    static int prev_base = -1;
-    static int prev_count = -1;            
-    int base = (pick_index/6)*6;
-    if (last_epoch != ui_epoch || base != prev_base || prev_count != num_reminders) {
-        fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
-        draw_line_text(4, title, COLOR_GREEN);
-        xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-        for (int i=0; i<6 && (base+i)<num_reminders; i++) {
-            char line[20];
-            const char* name = reminders[base+i].content;
-            snprintf(line, sizeof(line), "%c %.16s", (base+i)==pick_index?'>':' ', name);
-            draw_line_text(20 + i*12, line, ((base+i)==pick_index)? COLOR_YELLOW : COLOR_WHITE);
-        }
-        xSemaphoreGive(reminders_mutex);
-        draw_line_text(100, "OK:CHON  NEXT:LEN", COLOR_BLUE);
-        draw_line_text(112, "BACK:XUONG  CANCEL:THOAT", COLOR_BLUE);
-        prev_idx   = pick_index;
-        prev_base  = base;
-        prev_count = num_reminders;        
-        last_epoch = ui_epoch;
-        return;
-    }
-    if (prev_idx != pick_index) {
-        int old_row = prev_idx - base, new_row = pick_index - base;
-        if (old_row>=0 && old_row<6) {
-            char line[20];
-            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-            snprintf(line, sizeof(line), "  %.16s", reminders[prev_idx].content);
-            xSemaphoreGive(reminders_mutex);
-            draw_line_text(20 + old_row*12, line, COLOR_WHITE);
-        }
-        if (new_row>=0 && new_row<6) {
-            char line[20];
-            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-            snprintf(line, sizeof(line), "> %.16s", reminders[pick_index].content);
-            xSemaphoreGive(reminders_mutex);
-            draw_line_text(20 + new_row*12, line, COLOR_YELLOW);
-        }
-        prev_idx = pick_index;
-    }
+    static ListView lv = LIST_VIEW_INIT;
+    static const char *const hints[] = { "OK:CHON  NEXT:LEN", "BACK:XUONG  CANCEL:THOAT" };
+    list_view_draw(&lv, SCR_CONTENT_LIST, title, pick_index, num_reminders, content_row, reminders_mutex, hints, 2);
 }
 
 void ui_draw_preset_list(const char *title) {
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int prev_idx = -1;
-    static int prev_base = -1;
-    int base = (preset_index/6)*6;
-    if (last_epoch != ui_epoch || base != prev_base) {
-        fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
-        draw_line_text(4, title, COLOR_GREEN);
-        for (int i=0; i<6 && (base+i)<NUM_CONTENT_PRESETS; i++) {
-            char line[22];
-            snprintf(line, sizeof(line), "%c %.16s", (base+i)==preset_index?'>':' ', CONTENT_PRESETS[base+i]);
-            draw_line_text(20 + i*12, line, ((base+i)==preset_index)? COLOR_YELLOW : COLOR_WHITE);
-        }
-        draw_line_text(100, "OK:CHON  NEXT:LEN", COLOR_BLUE);
-        draw_line_text(112, "BACK:XUONG  CANCEL:THOAT", COLOR_BLUE);
-        prev_idx = preset_index;
-        prev_base = base;
-        last_epoch = ui_epoch;
-        return;
-    }
-    if (prev_idx != preset_index) {
-        int old_row = prev_idx - base, new_row = preset_index - base;
-        if (old_row>=0 && old_row<6) {
-            char line[22]; snprintf(line, sizeof(line), "  %.16s", CONTENT_PRESETS[prev_idx]);
-            draw_line_text(20 + old_row*12, line, COLOR_WHITE);
-        }
-        if (new_row>=0 && new_row<6) {
-            char line[22]; snprintf(line, sizeof(line), "> %.16s", CONTENT_PRESETS[preset_index]);
-            draw_line_text(20 + new_row*12, line, COLOR_YELLOW);
-        }
-        prev_idx = preset_index;
-    }
+    static ListView lv = LIST_VIEW_INIT;
+    static const char *const hints[] = { "OK:CHON  NEXT:LEN", "BACK:XUONG  CANCEL:THOAT" };
+    list_view_draw(&lv, SCR_PRESET_LIST, title, preset_index, NUM_CONTENT_PRESETS, preset_row, NULL, hints, 2);
 }
 
 void ui_draw_view_detail(void) {
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int      last_idx   = -1;
-    if (last_epoch != ui_epoch || last_idx != pick_index) {
-        fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
-        draw_line_text(4, "CHI TIET", COLOR_GREEN);
-        xSemaphoreTake(reminders_mutex, portMAX_DELAY);
-        Reminder r = reminders[pick_index];
-        xSemaphoreGive(reminders_mutex);
-        draw_line_text(24, "NGAY:", COLOR_YELLOW);
-        draw_string(60, 24, r.date, COLOR_WHITE);
-        char hhmm[6]; fmt_time(r.hour, r.minute, hhmm);
-        draw_line_text(36, "GIO:", COLOR_YELLOW);
-        draw_string(60, 36, hhmm, COLOR_WHITE);
-        draw_line_text(56, "NOI DUNG:", COLOR_YELLOW);
-        char line[22]; 
-        snprintf(line, sizeof(line), "%.20s", r.content);
-        draw_string(4, 68, line, COLOR_WHITE);
-        draw_line_text(100, "OK/CANCEL:QUAY LAI", COLOR_BLUE);
-        last_idx   = pick_index;
-        last_epoch = ui_epoch;
-    }
+    xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+    Reminder r = reminders[pick_index];
+    xSemaphoreGive(reminders_mutex);
+    char hhmm[6]; fmt_time(r.hour, r.minute, hhmm);
+    char line[64];
+    snprintf(line, sizeof(line), "%.*s", (int)utf8_prefix(r.content, 20), r.content);
+    ui_frame_begin(SCR_DETAIL);
+    ui_line(4, "CHI TIET", COLOR_GREEN);
+    ui_label(4, 24, "NGAY:", COLOR_YELLOW);
+    ui_label(60, 24, r.date, COLOR_WHITE);
+    ui_label(4, 36, "GIO:", COLOR_YELLOW);
+    ui_label(60, 36, hhmm, COLOR_WHITE);
+    ui_line(56, "NOI DUNG:", COLOR_YELLOW);
+    ui_line(68, line, COLOR_WHITE);
+    ui_hint(100, "OK/CANCEL:QUAY LAI");
+    ui_frame_end();
 }
 
 void ui_draw_edit_submenu(void) {
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int prev = -1;
-    if (last_epoch != ui_epoch) {
-        fill_rect(0,0,TFT_WIDTH,TFT_HEIGHT,COLOR_BLACK);
-        draw_line_text(4, "CHON TAC VU", COLOR_GREEN);
-        draw_line_text(24, (submenu_index==0)? "> CHINH NOI DUNG":"  CHINH NOI DUNG",
-                       (submenu_index==0)? COLOR_YELLOW:COLOR_WHITE);
-        draw_line_text(36, (submenu_index==1)? "> CHINH NGAY":"  CHINH NGAY",
-                       (submenu_index==1)? COLOR_YELLOW:COLOR_WHITE);
-        draw_line_text(48, (submenu_index==2)? "> CHINH GIO":"  CHINH GIO",
-                       (submenu_index==2)? COLOR_YELLOW:COLOR_WHITE);
-        draw_line_text(100,"OK:CHON  BACK/NEXT:DI CHUYEN", COLOR_BLUE);
-        draw_line_text(112,"CANCEL:QUAY LAI", COLOR_BLUE);
-        prev = submenu_index; last_epoch = ui_epoch; return;
-    }
-    if (prev!=submenu_index) {
-        draw_line_text(24, (submenu_index==0)? "> CHINH NOI DUNG":"  CHINH NOI DUNG",
-                       (submenu_index==0)? COLOR_YELLOW:COLOR_WHITE);
-        draw_line_text(36, (submenu_index==1)? "> CHINH NGAY":"  CHINH NGAY",
-                       (submenu_index==1)? COLOR_YELLOW:COLOR_WHITE);
-        draw_line_text(48, (submenu_index==2)? "> CHINH GIO":"  CHINH GIO",
-                       (submenu_index==2)? COLOR_YELLOW:COLOR_WHITE);
-        prev=submenu_index;
+    static const char *const items[] = { "CHINH NOI DUNG", "CHINH NGAY", "CHINH GIO" };
+    ui_frame_begin(SCR_SUBMENU);
+    ui_line(4, "CHON TAC VU", COLOR_GREEN);
+    for (int i = 0; i < 3; i++) {
+        char line[20];
+        snprintf(line, sizeof(line), "%c %s", submenu_index == i ? '>' : ' ', items[i]);
+        ui_line(24 + i*12, line, submenu_index == i ? COLOR_YELLOW : COLOR_WHITE);
     }
+    ui_hint(100, "OK:CHON  BACK/NEXT:DI CHUYEN");
+    ui_hint(112, "CANCEL:QUAY LAI");
+    ui_frame_end();
 }
 
 void ui_draw_date_editor(const char *title, int day, int month, TwoSel sel) {
-    const int FW = FONT_W, FH = FONT_H;
-    const int X0 = (TFT_WIDTH - 5*FW)/2; 
+    const int X0 = (TFT_WIDTH - 5*FONT_W)/2;
     const int Y0 = 60;
-    static uint32_t last_epoch = (uint32_t)-1;
-    static int pd=-1, pm=-1; static TwoSel psel=SEL_LEFT;
-    if (last_epoch != ui_epoch) {
-        fill_rect(0,0,TFT_WIDTH,TFT_HEIGHT,COLOR_BLACK);
-        draw_line_text(4, title, COLOR_GREEN);
-        draw_line_text(96,"NEXT/BACK:+/-", COLOR_BLUE);
-        draw_line_text(108,"OK:LUU TRUONG", COLOR_BLUE);
-        draw_line_text(120,"CANCEL:LUU & THOAT", COLOR_BLUE);
-        draw_string(X0 + 2*FW, Y0, "/", COLOR_WHITE);
-        pd=-1; pm=-1; psel=sel; last_epoch=ui_epoch;
-    }
-    uint16_t cD = (sel==SEL_LEFT)? COLOR_YELLOW:COLOR_WHITE;
-    uint16_t cM = (sel==SEL_RIGHT)?COLOR_YELLOW:COLOR_WHITE;
+    ui_frame_begin(SCR_DATE_EDIT);
+    ui_line(4, title, COLOR_GREEN);
+    ui_field(X0, Y0, day, 2, (sel==SEL_LEFT) ? COLOR_YELLOW : COLOR_WHITE);
+    ui_label(X0 + 2*FONT_W, Y0, "/", COLOR_WHITE);
+    ui_field(X0 + 3*FONT_W, Y0, month, 2, (sel==SEL_RIGHT) ? COLOR_YELLOW : COLOR_WHITE);
+    ui_hint(96, "NEXT/BACK:+/-");
+    ui_hint(108, "OK:LUU TRUONG");
+    ui_hint(120, "CANCEL:LUU & THOAT");
+    ui_frame_end();
+}
 
-    if (day!=pd || sel!=psel) {
-        char dd[3]={ '0'+(day/10),'0'+(day%10),0 };
-        fill_rect(X0, Y0, 2*FW, FH, COLOR_BLACK);
-        draw_string(X0, Y0, dd, cD);
-        pd=day;
-    }
-    if (month!=pm || sel!=psel) {
-        char mm[3]={ '0'+(month/10),'0'+(month%10),0 };
-        int mx = X0 + 3*FW;
-        fill_rect(mx, Y0, 2*FW, FH, COLOR_BLACK);
-        draw_string(mx, Y0, mm, cM);
-        pm=month;
-    }
-    psel=sel;
-} 
\ No newline at end of file
+#define CAL_CELL_W  18
+#define CAL_CELL_H  12
+#define CAL_GRID_X  1
+#define CAL_GRID_Y  26
+
+static void cal_cell(int d, int first_wd, const uint8_t *occ, bool sel, bool today) {
+    int idx = first_wd + d - 1;
+    int x = CAL_GRID_X + (idx % 7) * CAL_CELL_W;
+    int y = CAL_GRID_Y + (idx / 7) * CAL_CELL_H;
+    uint16_t fg = COLOR_WHITE;
+    if (occ[d-1] > 1)       fg = COLOR_RED;
+    else if (occ[d-1] == 1) fg = COLOR_YELLOW;
+    else if (today)         fg = COLOR_GREEN;
+    char s[3] = { (char)('0' + d/10), (char)('0' + d%10), 0 };
+    ui_cell(x, y, CAL_CELL_W, CAL_CELL_H, 3, 2, s, fg, sel ? COLOR_BLUE : COLOR_BLACK);
+}
+
+void ui_draw_calendar(void) {
+    static const char *wd[7] = { "T2", "T3", "T4", "T5", "T6", "T7", "CN" };
+    uint8_t occ[31];
+    xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+    int days = calendar_index_month_locked(cal_year, cal_month, occ);
+    xSemaphoreGive(reminders_mutex);
+    int first_wd = (int)((days_from_civil(cal_year, cal_month, 1) % 7 + 10) % 7);
+    struct tm t; ui_now_local(&t);
+    int today = (t.tm_year + 1900 == cal_year && t.tm_mon + 1 == cal_month) ? t.tm_mday : 0;
+    char title[20]; snprintf(title, sizeof(title), "THANG %02d %04d", cal_month, cal_year);
+    char info[24]; snprintf(info, sizeof(info), "NGAY %02d  %d LICH", cal_day, occ[cal_day-1]);
+
+    ui_frame_begin(SCR_CALENDAR);
+    ui_label(center_x(title), 4, title, COLOR_GREEN);
+    for (int i = 0; i < 7; i++) ui_label(CAL_GRID_X + i*CAL_CELL_W + 3, 15, wd[i], COLOR_BLUE);
+    for (int d = 1; d <= days; d++) cal_cell(d, first_wd, occ, d == cal_day, d == today);
+    // Dòng này đổi theo từng ngày nên vẽ bằng ô chữ thường, không chiếm chỗ trong bộ đệm dòng dựng sẵn
+    ui_cell(0, 100, TFT_WIDTH, STRIP_H, STRIP_TX, 0, info, COLOR_WHITE, COLOR_BLACK);
+    ui_hint(112, "NEXT/BACK:DOI NGAY");
+    ui_hint(124, "OK:THANG SAU");
+    ui_hint(136, "CANCEL:QUAY LAI");
+    ui_frame_end();
+}
\ No newline at end of file
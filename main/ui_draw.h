@@ -8,6 +8,17 @@
 #include "reminders_store.h"
 #include "time_utils.h"
 
+// Đồng hồ chờ "HH:MM" bằng chữ số lớn, ngày nằm ngay bên dưới
+#define IDLE_CLOCK_W  (5 * BIG_W - BIG_SCALE)
+#define IDLE_CLOCK_Y  36
+#define IDLE_DATE_DY  (BIG_H + 6)
+
+// Hàng biểu tượng trạng thái phía trên tiêu đề màn hình chờ
+#define IDLE_STATUS_Y   4
+#define IDLE_ST_WIFI    0x01
+#define IDLE_ST_MQTT    0x02
+#define IDLE_ST_SNOOZE  0x04
+
 typedef enum {
     UI_IDLE = 0,
     UI_MENU,
@@ -21,9 +32,25 @@ typedef enum {
     UI_ADD_DATE,       
     UI_ADD_TIME,       
     UI_DEL_PICK,        
-    UI_VIEW_DETAIL
+    UI_VIEW_DETAIL,
+    UI_CALENDAR
 } UiState;
 
+// Mã màn hình dùng cho widget và thống kê thời gian vẽ
+typedef enum {
+    SCR_IDLE = 0,
+    SCR_MENU,
+    SCR_TIME_EDIT,
+    SCR_DATE_EDIT,
+    SCR_DETAIL,
+    SCR_SUBMENU,
+    SCR_CALENDAR,
+    SCR_PICK_LIST,
+    SCR_CONTENT_LIST,
+    SCR_PRESET_LIST,
+    SCR_COUNT
+} UiScreen;
+
 typedef enum { SEL_LEFT=0, SEL_RIGHT=1 } TwoSel;
 
 typedef enum { SEL_HOUR = 0, SEL_MINUTE = 1 } FieldSel;
@@ -39,10 +66,13 @@ extern int menu_index;
 extern int pick_index;    
 extern FieldSel field_sel;
 extern int submenu_index;
+extern int cal_year, cal_month, cal_day;
 
-void show_alarm_feedback(const char *msg, uint16_t color);
+void show_alarm_feedback(const char *msg, uint16_t color, const Sprite *icon);
+void idle_draw_status(int flags, int old_flags);
 void idle_draw_upcoming(const struct tm* now_local);
-void draw_idle_screen_now(void);
+void idle_draw_clock(int hour, int min, int old_hour, int old_min);
+void draw_idle_screen_now(const struct tm *ti, int status);
 void idle_clock_screen_init(void);
 void ui_draw_menu(void);
 void ui_draw_pick_list(const char *title);
@@ -51,4 +81,5 @@ void ui_draw_list_content(const char *title);
 void ui_draw_preset_list(const char *title);
 void ui_draw_view_detail(void);
 void ui_draw_edit_submenu(void);
-void ui_draw_date_editor(const char *title, int day, int month, TwoSel sel);
\ No newline at end of file
+void ui_draw_date_editor(const char *title, int day, int month, TwoSel sel);
+void ui_draw_calendar(void);
\ No newline at end of file
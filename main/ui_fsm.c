@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "reminders_store.h"
+#include "ui_draw.h"
+#include "time_utils.h"
+#include "clock_source.h"
+#include "civil_time.h"
+#include "alarm_pipeline.h"
+#include "sntp.h"
+#include "ui_fsm.h"
+
+#define SET_STATE(S)  do { ui_state = (S); ui_epoch++; } while (0)
+
+static bool edit_active = false;
+static int edit_day = 1, edit_month = 1, edit_year = 2025; 
+static int edit_hour = 0, edit_min = 0;
+static SemaphoreHandle_t input_mutex = NULL;
+static struct tm pinned_tm;
+static bool clock_pinned = false;
+
+// Tạo khoá trước khi các task giao diện chạy, tránh hai task cùng tạo
+void ui_fsm_init(void) {
+    if (!input_mutex) input_mutex = xSemaphoreCreateMutex();
+}
+
+void ui_input_lock(void) {
+    xSemaphoreTake(input_mutex, portMAX_DELAY);
+}
+
+bool ui_input_trylock(void) {
+    return xSemaphoreTake(input_mutex, 0) == pdTRUE;
+}
+
+void ui_input_unlock(void) {
+    xSemaphoreGive(input_mutex);
+}
+
+// Ngày giờ giao diện dùng cho lịch và ngày mặc định; bộ phát lại ghim cố định để kết quả lặp lại được
+void ui_clock_pin(const struct tm *t) {
+    if (t) pinned_tm = *t;
+    clock_pinned = t != NULL;
+}
+
+void ui_now_local(struct tm *out) {
+    if (clock_pinned) *out = pinned_tm;
+    else clock_now_local(NULL, out);
+}
+
+// Gọi khi đang giữ ui_input_lock: về màn hình chờ với mọi chỉ số menu ở vị trí đầu
+void ui_reset_locked(void) {
+    menu_index = 0; submenu_index = 0; pick_index = 0; preset_index = 0;
+    two_sel = SEL_LEFT; field_sel = SEL_HOUR; edit_active = false;
+    SET_STATE(UI_IDLE);
+    idle_screen_invalidate();
+}
+
+void ui_handle_input(const BtnEdges *in) {
+    const BtnEdges e = *in;
+    switch (ui_state) {
+    case UI_IDLE: {
+        if (alarm_pipeline_active() && e.cancel_edge) {
+            alarm_pipeline_post(ALARM_EV_CANCEL, 0);
+            break;                        
+        }
+        if (e.ok_edge) {
+            if (alarm_pipeline_active()) {                    
+                alarm_pipeline_post(ALARM_EV_DISMISS, 0);
+            }
+            menu_index = 0;
+            SET_STATE(UI_MENU);
+            ui_draw_menu();
+        }
+        break;
+    }
+    break;
+    case UI_MENU:
+        if (e.next_edge) { if (menu_index>0) menu_index--; else menu_index=4; ui_draw_menu(); }
+        if (e.back_edge) { if (menu_index<4) menu_index++; else menu_index=0; ui_draw_menu(); }
+        if (e.ok_edge) {
+            if (menu_index == 0) { 
+                if (num_reminders==0) { SET_STATE(UI_IDLE); idle_screen_invalidate(); break; }
+                pick_index=0; SET_STATE(UI_VIEW_LIST); ui_draw_list_content("DANH SACH LICH");
+            } else if (menu_index == 1) { 
+                if (num_reminders==0) { SET_STATE(UI_IDLE); idle_screen_invalidate(); break; }
+                pick_index=0; SET_STATE(UI_EDIT_PICK); ui_draw_list_content("CHON LICH CAN CHINH");
+            } else if (menu_index == 2) { 
+                preset_index=0; two_sel=SEL_LEFT; edit_active=false;
+                struct tm t; ui_now_local(&t);
+                edit_year = t.tm_year + 1900;
+                SET_STATE(UI_ADD_CONTENT); ui_draw_preset_list("CHON NOI DUNG");
+            } else if (menu_index == 3) { 
+                if (num_reminders==0) { SET_STATE(UI_IDLE); idle_screen_invalidate(); break; }
+                pick_index=0; SET_STATE(UI_DEL_PICK); ui_draw_list_content("XOA LICH");
+            } else {
+                struct tm t; ui_now_local(&t);
+                cal_year = t.tm_year + 1900; cal_month = t.tm_mon + 1; cal_day = t.tm_mday;
+                SET_STATE(UI_CALENDAR); ui_draw_calendar();
+            }
+        }
+        if (e.cancel_edge) { 
+            SET_STATE(UI_IDLE); 
+            idle_screen_invalidate();
+        }
+        break;   
+    case UI_CALENDAR:
+        if (e.next_edge) {
+            if (--cal_day < 1) {
+                if (--cal_month < 1) { cal_month = 12; cal_year--; }
+                cal_day = civil_days_in_month(cal_year, cal_month);
+            }
+            ui_draw_calendar();
+        }
+        if (e.back_edge) {
+            if (++cal_day > civil_days_in_month(cal_year, cal_month)) {
+                cal_day = 1;
+                if (++cal_month > 12) { cal_month = 1; cal_year++; }
+            }
+            ui_draw_calendar();
+        }
+        if (e.ok_edge) {
+            cal_day = 1;
+            if (++cal_month > 12) { cal_month = 1; cal_year++; }
+            ui_draw_calendar();
+        }
+        if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
+        break;
+    case UI_VIEW_LIST:
+        if (e.next_edge) { if (pick_index>0) pick_index--; else pick_index=(num_reminders>0?num_reminders-1:0); ui_draw_list_content("DANH SACH LICH"); }
+        if (e.back_edge) { if (pick_index<num_reminders-1) pick_index++; else pick_index=0; ui_draw_list_content("DANH SACH LICH"); }
+        if (e.ok_edge)   { SET_STATE(UI_VIEW_DETAIL); ui_draw_view_detail(); }
+        if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
+        break;
+    case UI_VIEW_DETAIL:
+        if (e.ok_edge || e.cancel_edge) {
+            SET_STATE(UI_VIEW_LIST);
+            ui_draw_list_content("DANH SACH LICH");
+        }
+        break;
+    case UI_EDIT_PICK:
+        if (e.next_edge) { if (pick_index>0) pick_index--; else pick_index=(num_reminders>0?num_reminders-1:0); ui_draw_list_content("CHON LICH CAN CHINH"); }
+        if (e.back_edge) { if (pick_index<num_reminders-1) pick_index++; else pick_index=0; ui_draw_list_content("CHON LICH CAN CHINH"); }
+        if (e.ok_edge) {
+            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+            edit_hour  = reminders[pick_index].hour;
+            edit_min   = reminders[pick_index].minute;
+            bool date_ok = parse_date(reminders[pick_index].date, &edit_year, &edit_month, &edit_day);
+            xSemaphoreGive(reminders_mutex);
+            if (!date_ok) {
+                struct tm ti; ui_now_local(&ti);
+                edit_year = ti.tm_year + 1900; edit_month = ti.tm_mon + 1; edit_day = ti.tm_mday;
+            }
+            submenu_index = 0; edit_active=false; two_sel=SEL_LEFT;
+            SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
+        }
+        if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
+        break;
+    case UI_EDIT_SUBMENU:
+        if (e.next_edge) { if (submenu_index>0) submenu_index--; else submenu_index=2; ui_draw_edit_submenu(); }
+        if (e.back_edge) { if (submenu_index<2) submenu_index++; else submenu_index=0; ui_draw_edit_submenu(); }
+        if (e.ok_edge) {
+            if (submenu_index==0) { 
+                preset_index=0;
+                SET_STATE(UI_EDIT_CONTENT); ui_draw_preset_list("CHON NOI DUNG MOI");
+            } else if (submenu_index==1) { 
+                two_sel=SEL_LEFT; edit_active=false;
+                SET_STATE(UI_EDIT_DATE); ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
+            } else { 
+                field_sel=SEL_HOUR; edit_active=false;
+                SET_STATE(UI_EDIT_TIME); ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
+            }
+        }
+        if (e.cancel_edge){ SET_STATE(UI_EDIT_PICK); ui_draw_list_content("CHON LICH CAN CHINH"); }
+        break;
+    case UI_EDIT_CONTENT:
+        if (e.next_edge) { if (preset_index>0) preset_index--; else preset_index=NUM_CONTENT_PRESETS-1; ui_draw_preset_list("CHON NOI DUNG MOI"); }
+        if (e.back_edge) { if (preset_index<NUM_CONTENT_PRESETS-1) preset_index++; else preset_index=0; ui_draw_preset_list("CHON NOI DUNG MOI"); }
+        if (e.ok_edge) {
+            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+		        strncpy(reminders[pick_index].content, CONTENT_PRESETS[preset_index], sizeof(reminders[pick_index].content)-1);
+		        reminders[pick_index].content[sizeof(reminders[pick_index].content)-1] = 0;
+		        xSemaphoreGive(reminders_mutex);
+		        update_reminder(reminders[pick_index].id, reminders[pick_index].date, reminders[pick_index].hour, reminders[pick_index].minute, reminders[pick_index].content, reminders[pick_index].status);
+		        save_reminders_to_nvs();
+            SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
+        }
+        if (e.cancel_edge){ SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu(); }
+        break;
+    case UI_EDIT_DATE:
+        if (e.next_edge) {
+            if (!edit_active) { two_sel = (two_sel==SEL_LEFT)?SEL_RIGHT:SEL_LEFT; }
+            else { if (two_sel==SEL_LEFT) { edit_day++; } else { edit_month++; } clamp_day_month_y(&edit_day,&edit_month,edit_year); }
+            ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
+        }
+        if (e.back_edge) {
+            if (!edit_active) { two_sel = (two_sel==SEL_LEFT)?SEL_RIGHT:SEL_LEFT; }
+            else { if (two_sel==SEL_LEFT) { edit_day--; } else { edit_month--; } clamp_day_month_y(&edit_day,&edit_month,edit_year); }
+            ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
+        }
+        if (e.ok_edge) {
+            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+		        fmt_date(edit_year, edit_month, edit_day, reminders[pick_index].date);
+		        xSemaphoreGive(reminders_mutex);
+		        update_reminder(reminders[pick_index].id, reminders[pick_index].date, reminders[pick_index].hour, reminders[pick_index].minute, reminders[pick_index].content, reminders[pick_index].status);
+		        edit_active = !edit_active; 
+            save_reminders_to_nvs();
+		        ui_draw_date_editor("CHINH NGAY", edit_day, edit_month, two_sel);
+         }
+        if (e.cancel_edge) {
+            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+            fmt_date(edit_year, edit_month, edit_day, reminders[pick_index].date);
+            reminder_changed_locked(&reminders[pick_index]);
+            xSemaphoreGive(reminders_mutex);
+            SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
+        }
+        break;
+    case UI_EDIT_TIME:
+        if (e.next_edge) {
+            if (!edit_active) { field_sel=(field_sel==SEL_HOUR)?SEL_MINUTE:SEL_HOUR; }
+            else { if (field_sel==SEL_HOUR) edit_hour++; else edit_min++; clamp_time(&edit_hour,&edit_min); }
+            ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
+        }
+        if (e.back_edge) {
+            if (!edit_active) { field_sel=(field_sel==SEL_HOUR)?SEL_MINUTE:SEL_HOUR; }
+            else { if (field_sel==SEL_HOUR) edit_hour--; else edit_min--; clamp_time(&edit_hour,&edit_min); }
+            ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
+        }
+        if (e.ok_edge) {
+            if (edit_active) {
+                xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+		            if (field_sel==SEL_HOUR) reminders[pick_index].hour=edit_hour; else reminders[pick_index].minute=edit_min;
+		            xSemaphoreGive(reminders_mutex);
+		            update_reminder(reminders[pick_index].id, reminders[pick_index].date, reminders[pick_index].hour, reminders[pick_index].minute, reminders[pick_index].content, reminders[pick_index].status);
+                save_reminders_to_nvs();
+            }
+            edit_active=!edit_active;
+            ui_draw_time_editor("CHINH GIO", edit_hour, edit_min, field_sel, true);
+        }
+        if (e.cancel_edge) {
+            xSemaphoreTake(reminders_mutex, portMAX_DELAY);
+            reminders[pick_index].hour=edit_hour; reminders[pick_index].minute=edit_min;
+            reminder_changed_locked(&reminders[pick_index]);
+            xSemaphoreGive(reminders_mutex);
+            SET_STATE(UI_EDIT_SUBMENU); ui_draw_edit_submenu();
+        }
+        break;
+    case UI_ADD_CONTENT:
+        if (e.next_edge) { if (preset_index>0) preset_index--; else preset_index=NUM_CONTENT_PRESETS-1; ui_draw_preset_list("CHON NOI DUNG"); }
+        if (e.back_edge) { if (preset_index<NUM_CONTENT_PRESETS-1) preset_index++; else preset_index=0; ui_draw_preset_list("CHON NOI DUNG"); }
+        if (e.ok_edge) {
+            edit_day=1; edit_month=1; two_sel=SEL_LEFT; edit_active=false;
+            SET_STATE(UI_ADD_DATE); ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
+        }
+        if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
+        break;
+    case UI_ADD_DATE:
+        if (e.next_edge) {
+            if (two_sel==SEL_LEFT) { edit_day++; } else { edit_month++; }
+            clamp_day_month_y(&edit_day,&edit_month,edit_year);
+            ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
+        }
+        if (e.back_edge) {
+            if (two_sel==SEL_LEFT) { edit_day--; } else { edit_month--; }
+            clamp_day_month_y(&edit_day,&edit_month,edit_year);
+            ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
+        }
+        if (e.ok_edge) {
+            if (two_sel==SEL_LEFT) {
+                two_sel = SEL_RIGHT; 
+                ui_draw_date_editor("CHON NGAY THANG", edit_day, edit_month, two_sel);
+            } else {
+                field_sel = SEL_HOUR; edit_hour=0; edit_min=0;
+                SET_STATE(UI_ADD_TIME); ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
+            }
+        }
+        if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
+        break;
+    case UI_ADD_TIME:
+        if (e.next_edge) {
+            if (field_sel==SEL_HOUR) { edit_hour++; } else { edit_min++; }
+            clamp_time(&edit_hour,&edit_min);
+            ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
+        }
+        if (e.back_edge) {
+            if (field_sel==SEL_HOUR) { edit_hour--; } else { edit_min--; }
+            clamp_time(&edit_hour,&edit_min);
+            ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
+        }
+        if (e.ok_edge) {
+            if (field_sel==SEL_HOUR) {
+            field_sel=SEL_MINUTE; 
+            ui_draw_time_editor("CHON GIO", edit_hour, edit_min, field_sel, false);
+            } else {
+                char new_date[11]; fmt_date(edit_year, edit_month, edit_day, new_date);
+					add_reminder_full(next_id, new_date, edit_hour, edit_min, CONTENT_PRESETS[preset_index], "pending");
+                save_reminders_to_nvs();
+                SET_STATE(UI_MENU); ui_draw_menu();
+            }
+        }
+        if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
+        break;
+    case UI_DEL_PICK:
+        if (e.next_edge) { if (pick_index>0) pick_index--; else pick_index=(num_reminders>0?num_reminders-1:0); ui_draw_list_content("XOA LICH"); }
+        if (e.back_edge) { if (pick_index<num_reminders-1) pick_index++; else pick_index=0; ui_draw_list_content("XOA LICH"); }
+        if (e.ok_edge) {
+            delete_reminder_at(pick_index);
+            save_reminders_to_nvs();
+            if (num_reminders==0) { SET_STATE(UI_MENU); ui_draw_menu(); }
+            else { if (pick_index>=num_reminders) pick_index=num_reminders-1; ui_draw_list_content("XOA LICH"); }
+        }
+        if (e.cancel_edge){ SET_STATE(UI_MENU); ui_draw_menu(); }
+        break;
+    }
+}
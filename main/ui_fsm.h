@@ -0,0 +1,15 @@
+#pragma once
+#include <time.h>
+#include "ui_buttons.h"
+
+// Máy trạng thái giao diện: xử lý một sự kiện phím trên màn hình hiện tại.
+// ui_task và bộ phát lại (input_log) đều gọi qua ui_input_lock để không chen nhau;
+// print_time_task chỉ vẽ màn hình chờ khi ui_input_trylock lấy được khoá.
+void ui_fsm_init(void);
+void ui_handle_input(const BtnEdges *in);
+void ui_input_lock(void);
+bool ui_input_trylock(void);
+void ui_input_unlock(void);
+void ui_reset_locked(void);
+void ui_clock_pin(const struct tm *t);
+void ui_now_local(struct tm *out);
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "display.h"
+#include "ui_draw.h"
+#include "ui_perf.h"
+
+#if CONFIG_DISPLAY_PERF
+#include "cJSON.h"
+#include "mqtt.h"
+
+#define TAG "UiPerf"
+
+#define PERF_BUCKETS      12
+#define PERF_PENDING      8
+#define PERF_INPUT_MAX_US 1000000   // phím không dẫn tới khung nào trong 1 s thì bỏ
+#define US_SHIFT          6         // ô 0: < 128 us, ô cuối: >= 131 ms
+#define BYTES_SHIFT       8         // ô 0: < 512 B, ô cuối: >= 512 KB
+
+typedef enum { M_RENDER, M_PIXEL, M_LATENCY, M_BYTES, M_COUNT } Metric;
+
+typedef struct {
+    uint32_t n;
+    uint32_t max;
+    uint64_t sum;
+    uint16_t hist[PERF_BUCKETS];
+} Hist;
+
+typedef struct {
+    int16_t screen;
+    int64_t t_begin;
+    int64_t t_input;
+} Pending;
+
+static const char *const screen_names[SCR_COUNT] = {
+    "idle", "menu", "time_edit", "date_edit", "detail", "submenu",
+    "calendar", "pick_list", "content_list", "preset_list",
+};
+static const char *const metric_names[M_COUNT] = { "render_us", "pixel_us", "latency_us", "bytes" };
+static const uint8_t metric_shift[M_COUNT] = { US_SHIFT, US_SHIFT, US_SHIFT, BYTES_SHIFT };
+
+static SemaphoreHandle_t perf_mutex = NULL;
+static Hist hists[SCR_COUNT][M_COUNT];
+static Pending pending[PERF_PENDING];
+static uint32_t frame_seq = 0;
+static int64_t input_at = 0;
+
+static void hist_add(Hist *h, uint32_t v, int shift) {
+    int b = 0;
+    for (uint32_t x = v >> (shift + 1); x && b < PERF_BUCKETS - 1; x >>= 1) b++;
+    h->hist[b]++;
+    h->n++;
+    h->sum += v;
+    if (v > h->max) h->max = v;
+}
+
+// Cận trên của ô chứa phân vị q (%)
+static uint32_t hist_pct(const Hist *h, int q, int shift) {
+    uint32_t want = (h->n * q + 99) / 100, acc = 0;
+    for (int b = 0; b < PERF_BUCKETS; b++) {
+        acc += h->hist[b];
+        if (acc >= want) {
+            uint32_t top = 1u << (b + shift + 1);
+            return b == PERF_BUCKETS - 1 || top > h->max ? h->max : top;
+        }
+    }
+    return h->max;
+}
+
+static void record(int screen, Metric m, int64_t v) {
+    if (screen < 0 || screen >= SCR_COUNT || v < 0) return;
+    xSemaphoreTake(perf_mutex, portMAX_DELAY);
+    hist_add(&hists[screen][m], v > UINT32_MAX ? UINT32_MAX : (uint32_t)v, metric_shift[m]);
+    xSemaphoreGive(perf_mutex);
+}
+
+// Tác vụ hiển thị gọi khi khung đã ra tới màn hình
+static void frame_shown(uint32_t tag, uint32_t bytes) {
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(perf_mutex, portMAX_DELAY);
+    Pending p = pending[tag % PERF_PENDING];
+    xSemaphoreGive(perf_mutex);
+    record(p.screen, M_PIXEL, now - p.t_begin);
+    if (p.t_input) record(p.screen, M_LATENCY, now - p.t_input);
+    record(p.screen, M_BYTES, bytes);
+}
+
+// Gọi một lần từ app_main trước khi tạo các task giao diện
+void perf_init(void) {
+    if (perf_mutex) return;
+    perf_mutex = xSemaphoreCreateMutex();
+    display_set_mark_hook(frame_shown);
+}
+
+void perf_input_edge(void) {
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(perf_mutex, portMAX_DELAY);
+    if (!input_at) input_at = now;
+    xSemaphoreGive(perf_mutex);
+}
+
+PerfFrame perf_frame_begin(int screen) {
+    return (PerfFrame){ .screen = (int16_t)screen, .t_begin = esp_timer_get_time() };
+}
+
+void perf_frame_end(PerfFrame f) {
+    if (f.screen < 0 || f.screen >= SCR_COUNT) return;
+    int64_t now = esp_timer_get_time();
+    record(f.screen, M_RENDER, now - f.t_begin);
+    xSemaphoreTake(perf_mutex, portMAX_DELAY);
+    int64_t t_in = input_at;
+    if (t_in && now - t_in > PERF_INPUT_MAX_US) t_in = 0;
+    input_at = 0;
+    uint32_t tag = frame_seq++;
+    pending[tag % PERF_PENDING] = (Pending){ .screen = f.screen, .t_begin = f.t_begin, .t_input = t_in };
+    xSemaphoreGive(perf_mutex);
+    display_mark(tag);
+}
+
+void perf_log(void) {
+    xSemaphoreTake(perf_mutex, portMAX_DELAY);
+    for (int s = 0; s < SCR_COUNT; s++) {
+        if (!hists[s][M_RENDER].n) continue;
+        for (int m = 0; m < M_COUNT; m++) {
+            const Hist *h = &hists[s][m];
+            if (!h->n) continue;
+            ESP_LOGI(TAG, "%-12s %-10s n=%lu avg=%lu p50<=%lu p90<=%lu max=%lu", screen_names[s], metric_names[m],
+                     (unsigned long)h->n, (unsigned long)(h->sum / h->n),
+                     (unsigned long)hist_pct(h, 50, metric_shift[m]), (unsigned long)hist_pct(h, 90, metric_shift[m]),
+                     (unsigned long)h->max);
+        }
+    }
+    xSemaphoreGive(perf_mutex);
+}
+
+// Mỗi màn hình một bản tin tới reminders/perf; hist là số khung trong từng ô lũy thừa 2
+void perf_publish(void) {
+    for (int s = 0; s < SCR_COUNT; s++) {
+        xSemaphoreTake(perf_mutex, portMAX_DELAY);
+        Hist snap[M_COUNT];
+        memcpy(snap, hists[s], sizeof(snap));
+        xSemaphoreGive(perf_mutex);
+        if (!snap[M_RENDER].n) continue;
+        cJSON *j = cJSON_CreateObject();
+        cJSON_AddStringToObject(j, "screen", screen_names[s]);
+        for (int m = 0; m < M_COUNT; m++) {
+            const Hist *h = &snap[m];
+            cJSON *o = cJSON_AddObjectToObject(j, metric_names[m]);
+            cJSON_AddNumberToObject(o, "n", h->n);
+            cJSON_AddNumberToObject(o, "avg", h->n ? (double)(h->sum / h->n) : 0);
+            cJSON_AddNumberToObject(o, "max", h->max);
+            cJSON_AddNumberToObject(o, "shift", metric_shift[m] + 1);
+            cJSON *arr = cJSON_AddArrayToObject(o, "hist");
+            for (int b = 0; b < PERF_BUCKETS; b++) cJSON_AddItemToArray(arr, cJSON_CreateNumber(h->hist[b]));
+        }
+        char *str = cJSON_PrintUnformatted(j);
+        if (str) {
+            mqtt_publish("reminders/perf", str, 0, 0);
+            free(str);
+        }
+        cJSON_Delete(j);
+    }
+}
+
+void perf_reset(void) {
+    xSemaphoreTake(perf_mutex, portMAX_DELAY);
+    memset(hists, 0, sizeof(hists));
+    xSemaphoreGive(perf_mutex);
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+#include "sdkconfig.h"
+
+// Khung đang vẽ: perf_frame_begin trả về, người gọi giữ và đưa lại cho perf_frame_end,
+// nên print_time_task và ui_task đo khung của mình mà không dùng chung biến
+typedef struct {
+    int16_t screen;
+    int64_t t_begin;
+} PerfFrame;
+
+#if CONFIG_DISPLAY_PERF
+void perf_init(void);
+void perf_input_edge(void);
+PerfFrame perf_frame_begin(int screen);
+void perf_frame_end(PerfFrame f);
+void perf_log(void);
+void perf_publish(void);
+void perf_reset(void);
+#else
+static inline void perf_init(void) {}
+static inline void perf_input_edge(void) {}
+static inline PerfFrame perf_frame_begin(int screen) { return (PerfFrame){ .screen = (int16_t)screen }; }
+static inline void perf_frame_end(PerfFrame f) { (void)f; }
+static inline void perf_log(void) {}
+static inline void perf_publish(void) {}
+static inline void perf_reset(void) {}
+#endif
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "display.h"
+#include "ui_draw.h"
+#include "ui_widgets.h"
+#include "glyph.h"
+#include "ui_perf.h"
+
+// Mỗi màn hình khai báo lại toàn bộ widget theo cùng thứ tự mỗi lần vẽ;
+// widget thứ i được so với widget thứ i của khung trước và chỉ vẽ lại khi khác.
+// Các widget trong một khung không được chồng lên nhau.
+typedef struct {
+    int16_t  x, y, w, h;
+    int8_t   tx, ty;
+    bool     strip;
+    uint16_t fg, bg;
+    char     text[64];
+} Widget;
+
+static Widget prev[UI_MAX_WIDGETS], cur[UI_MAX_WIDGETS];
+static int prev_n = 0, cur_n = 0;
+static int prev_screen = -1, cur_screen = -1;
+static uint32_t prev_epoch = (uint32_t)-1;
+static PerfFrame frame_perf;
+
+void ui_frame_begin(int screen) {
+    frame_perf = perf_frame_begin(screen);
+    cur_screen = screen;
+    cur_n = 0;
+}
+
+static Widget *widget_add(int x, int y, int w, int h, const char *text, uint16_t fg, uint16_t bg) {
+    if (cur_n >= UI_MAX_WIDGETS) return NULL;
+    Widget *wd = &cur[cur_n++];
+    memset(wd, 0, sizeof(*wd));
+    wd->x = x; wd->y = y; wd->w = w; wd->h = h;
+    wd->fg = fg; wd->bg = bg;
+    if (text) {
+        size_t n = strlen(text);
+        if (n > sizeof(wd->text) - 1) {
+            n = sizeof(wd->text) - 1;
+            while (n > 0 && (text[n] & 0xC0) == 0x80) n--;
+        }
+        memcpy(wd->text, text, n);
+    }
+    return wd;
+}
+
+void ui_line(int y, const char *text, uint16_t color) {
+    Widget *wd = widget_add(0, y, TFT_WIDTH, STRIP_H, text, color, COLOR_BLACK);
+    if (wd) { wd->tx = STRIP_TX; wd->strip = true; }
+}
+
+void ui_hint(int y, const char *text) {
+    ui_line(y, text, COLOR_BLUE);
+}
+
+void ui_label(int x, int y, const char *text, uint16_t color) {
+    widget_add(x, y, (int)utf8_glyphs(text, strlen(text)) * FONT_W, FONT_H, text, color, COLOR_BLACK);
+}
+
+void ui_field(int x, int y, int value, int digits, uint16_t color) {
+    char buf[12];
+    snprintf(buf, sizeof(buf), "%0*d", digits, value);
+    widget_add(x, y, digits * FONT_W, FONT_H, buf, color, COLOR_BLACK);
+}
+
+void ui_cell(int x, int y, int w, int h, int tx, int ty, const char *text, uint16_t fg, uint16_t bg) {
+    Widget *wd = widget_add(x, y, w, h, text, fg, bg);
+    if (wd) { wd->tx = tx; wd->ty = ty; }
+}
+
+static void widget_draw(const Widget *wd) {
+    if (wd->strip) {
+        draw_strip(wd->y, wd->text, wd->fg, wd->bg);
+        return;
+    }
+    fill_rect(wd->x, wd->y, wd->w, wd->h, wd->bg);
+    if (wd->text[0]) draw_string_bg(wd->x + wd->tx, wd->y + wd->ty, wd->text, wd->fg, wd->bg);
+}
+
+static bool same_rect(const Widget *a, const Widget *b) {
+    return a->x == b->x && a->y == b->y && a->w == b->w && a->h == b->h;
+}
+
+static bool overlaps(const Widget *a, const Widget *b) {
+    return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+void ui_frame_end(void) {
+    if (cur_screen != prev_screen || ui_epoch != prev_epoch) {
+        fill_rect(0, 0, TFT_WIDTH, TFT_HEIGHT, COLOR_BLACK);
+        for (int i = 0; i < cur_n; i++) widget_draw(&cur[i]);
+    } else {
+        // Xóa trước các vùng cũ đã mất hoặc đổi chỗ, rồi vẽ widget đổi nội dung hoặc bị vùng xóa chạm vào
+        Widget *cleared[UI_MAX_WIDGETS];
+        int nc = 0;
+        for (int i = 0; i < prev_n; i++) {
+            if (i < cur_n && same_rect(&cur[i], &prev[i])) continue;
+            fill_rect(prev[i].x, prev[i].y, prev[i].w, prev[i].h, COLOR_BLACK);
+            cleared[nc++] = &prev[i];
+        }
+        for (int i = 0; i < cur_n; i++) {
+            bool dirty = i >= prev_n || memcmp(&cur[i], &prev[i], sizeof(Widget)) != 0;
+            for (int k = 0; k < nc && !dirty; k++) dirty = overlaps(&cur[i], cleared[k]);
+            if (dirty) widget_draw(&cur[i]);
+        }
+    }
+    memcpy(prev, cur, sizeof(Widget) * cur_n);
+    prev_n = cur_n;
+    prev_screen = cur_screen;
+    prev_epoch = ui_epoch;
+    perf_frame_end(frame_perf);
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+
+#define UI_MAX_WIDGETS 48
+
+void ui_frame_begin(int screen);
+void ui_frame_end(void);
+void ui_line(int y, const char *text, uint16_t color);
+void ui_hint(int y, const char *text);
+void ui_label(int x, int y, const char *text, uint16_t color);
+void ui_field(int x, int y, int value, int digits, uint16_t color);
+void ui_cell(int x, int y, int w, int h, int tx, int ty, const char *text, uint16_t fg, uint16_t bg);
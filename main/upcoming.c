@@ -0,0 +1,111 @@
+#include <limits.h>
+#include <string.h>
+#include "clock_source.h"
+#include "civil_time.h"
+#include "tz.h"
+#include "upcoming.h"
+
+#define RANK_REPEAT  0
+#define RANK_PENDING 1
+#define RANK_OTHER   2
+
+// Các lịch chưa hoàn thành, sắp theo (rank, phút địa phương của lần báo kế tiếp)
+static UpcomingEntry view[MAX_REMINDERS];
+static int view_n = 0;
+static long view_now = LONG_MIN;
+static uint32_t view_tz_gen = 0;
+
+static int status_rank(const char *s) {
+    if (strncmp(s, "repeat",  6) == 0) return RANK_REPEAT;
+    if (strncmp(s, "pending", 7) == 0) return RANK_PENDING;
+    return RANK_OTHER;
+}
+
+long upcoming_local_min(const struct tm *t) {
+    return (long)days_from_civil(t->tm_year + 1900, t->tm_mon + 1, t->tm_mday) * 1440
+         + t->tm_hour * 60 + t->tm_min;
+}
+
+long upcoming_now_min(void) {
+    time_t now = clock_now();
+    return (long)((now + tz_offset_at(now)) / 60);
+}
+
+static long repeat_key(const Reminder *r, long now_min) {
+    long k = (now_min / 1440) * 1440 + r->hour * 60 + r->minute;
+    return (k < now_min) ? k + 1440 : k;
+}
+
+static bool entry_before(const UpcomingEntry *a, const UpcomingEntry *b) {
+    return a->rank < b->rank || (a->rank == b->rank && a->key < b->key);
+}
+
+static void remove_at(int i) {
+    memmove(&view[i], &view[i+1], (size_t)(view_n - i - 1) * sizeof(view[0]));
+    view_n--;
+}
+
+static void insert_sorted(const UpcomingEntry *e) {
+    if (view_n >= MAX_REMINDERS) return;
+    int i = view_n;
+    while (i > 0 && entry_before(e, &view[i-1])) i--;
+    memmove(&view[i+1], &view[i], (size_t)(view_n - i) * sizeof(view[0]));
+    view[i] = *e;
+    view_n++;
+}
+
+static void put_at(const Reminder *r, long now_min) {
+    if (strncmp(r->status, "completed", 9) == 0) return;
+    UpcomingEntry e = { .rank = status_rank(r->status), .r = *r };
+    if (e.rank == RANK_REPEAT) {
+        e.key = repeat_key(r, now_min);
+    } else {
+        int y, m, d;
+        if (!civil_parse_date(r->date, &y, &m, &d)) return;
+        e.key = (long)days_from_civil(y, m, d) * 1440 + r->hour * 60 + r->minute;
+        if (e.key < now_min) return;
+    }
+    insert_sorted(&e);
+}
+
+void upcoming_rebuild_locked(void) {
+    long now_min = upcoming_now_min();
+    view_n = 0;
+    view_now = now_min;
+    view_tz_gen = tz_generation();
+    for (int i = 0; i < num_reminders; i++) put_at(&reminders[i], now_min);
+}
+
+void upcoming_remove_locked(int id) {
+    for (int i = 0; i < view_n; i++) {
+        if (view[i].r.id == id) { remove_at(i); return; }
+    }
+}
+
+void upcoming_put_locked(const Reminder *r) {
+    upcoming_remove_locked(r->id);
+    put_at(r, view_now == LONG_MIN ? upcoming_now_min() : view_now);
+}
+
+static void advance_locked(long now_min) {
+    if (tz_generation() != view_tz_gen || now_min < view_now) { upcoming_rebuild_locked(); return; }
+    if (now_min == view_now) return;
+    view_now = now_min;
+    int i = 0;
+    while (i < view_n) {
+        if (view[i].key >= now_min) { i++; continue; }
+        UpcomingEntry e = view[i];
+        remove_at(i);
+        if (e.rank == RANK_REPEAT) {
+            e.key = repeat_key(&e.r, now_min);
+            insert_sorted(&e);
+        }
+    }
+}
+
+int upcoming_top_locked(long now_min, UpcomingEntry *out, int k) {
+    advance_locked(now_min);
+    int n = (k < view_n) ? k : view_n;
+    memcpy(out, view, (size_t)n * sizeof(view[0]));
+    return n;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "reminders_store.h"
+
+#define UPCOMING_K  CONFIG_REMINDER_UPCOMING_K
+
+typedef struct {
+    long     key;
+    int      rank;
+    Reminder r;
+} UpcomingEntry;
+
+long upcoming_now_min(void);
+long upcoming_local_min(const struct tm *t);
+void upcoming_rebuild_locked(void);
+void upcoming_put_locked(const Reminder *r);
+void upcoming_remove_locked(int id);
+int  upcoming_top_locked(long now_min, UpcomingEntry *out, int k);
@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Convert button logs between the firmware hex format and a readable script.
+
+Usage: input_log.py decode <hex | file with MQTT JSON from reminders/input>
+       input_log.py encode script.txt
+
+A script has one event per line: "<delay_ms> <OK|BACK|NEXT|CANCEL> [repeat]",
+'#' starts a comment. "NEXT*5" is shorthand for five presses 150 ms apart.
+encode prints the hex log and the MQTT payload that replays it. Incoming MQTT
+messages are limited to 256 bytes, so one payload holds about 35 events. Longer
+scripts are split into several payloads; send each one after the previous
+reminders/input/result message has arrived.
+"""
+import json
+import sys
+
+BUTTONS = ["OK", "BACK", "NEXT", "CANCEL"]
+REC = 3
+MQTT_EVENTS = 35
+
+
+def decode(hexlog):
+    data = bytes.fromhex(hexlog)
+    t = 0
+    for i in range(0, len(data) - len(data) % REC, REC):
+        dt = data[i] | (data[i + 1] << 8)
+        btn, rep = data[i + 2] & 3, data[i + 2] >> 2
+        t += dt
+        print("%6d %-6s%s    # t=%d ms" % (dt, BUTTONS[btn], " %d" % rep if rep else "", t))
+
+
+def encode(path):
+    out = bytearray()
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+            dt = int(line[0])
+            name, _, count = line[1].upper().partition("*")
+            rep = int(line[2]) if len(line) > 2 else 0
+            for k in range(int(count or 1)):
+                d = dt if k == 0 else 150
+                out += bytes([d & 0xFF, d >> 8, BUTTONS.index(name) | (min(rep, 63) << 2)])
+    print(out.hex())
+    for i in range(0, len(out), MQTT_EVENTS * REC):
+        print(json.dumps({"action": "input", "op": "replay", "log": out[i:i + MQTT_EVENTS * REC].hex()},
+                         separators=(",", ":")))
+
+
+def main():
+    if len(sys.argv) < 3 or sys.argv[1] not in ("decode", "encode"):
+        print(__doc__)
+        return 1
+    if sys.argv[1] == "encode":
+        encode(sys.argv[2])
+        return 0
+    arg = sys.argv[2]
+    try:
+        with open(arg) as f:
+            text = f.read().strip()
+        arg = json.loads(text)["log"] if text.startswith("{") else text
+    except OSError:
+        pass
+    decode(arg)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
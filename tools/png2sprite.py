@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""Convert PNG icons into RLE-compressed sprite tables for the firmware.
+
+Usage: png2sprite.py -o <out_base> icon1.png [icon2.png ...]
+
+Writes <out_base>.c and <out_base>.h with one `const Sprite icon_<name>`
+per PNG (name = file stem, '-' becomes '_'). Each sprite has its own
+RGB565 palette of at most 15 colours; index 0 is transparent (alpha < 128).
+Pixels are stored row-major as runs: one byte per run,
+(length - 1) << 4 | palette index, so a run covers 1..16 pixels and may
+continue onto the next row. Only the standard library is used, so the
+script runs in the ESP-IDF Python environment during the build.
+"""
+import os
+import struct
+import sys
+import zlib
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(path):
+    """Return (w, h, rows) with rows as lists of (r, g, b, a)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("%s: not a PNG" % path)
+    pos, idat, plte, trns = 8, b"", None, None
+    while pos < len(data):
+        n, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + n]
+        pos += 12 + n
+        if kind == b"IHDR":
+            w, h, depth, ctype, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            plte = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+    if depth != 8 or interlace:
+        raise ValueError("%s: only 8-bit non-interlaced PNGs are supported" % path)
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    raw = zlib.decompress(idat)
+    stride = w * channels
+    prev = bytearray(stride)
+    rows = []
+    for y in range(h):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - channels] if i >= channels else 0
+            b = prev[i]
+            c = prev[i - channels] if i >= channels else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                line[i] = (line[i] + paeth(a, b, c)) & 0xFF
+        prev = line
+        px = []
+        for x in range(w):
+            v = line[x * channels:(x + 1) * channels]
+            if ctype == 0:
+                px.append((v[0], v[0], v[0], 255))
+            elif ctype == 2:
+                px.append((v[0], v[1], v[2], 255))
+            elif ctype == 3:
+                alpha = trns[v[0]] if trns and v[0] < len(trns) else 255
+                px.append(plte[v[0]] + (alpha,))
+            elif ctype == 4:
+                px.append((v[0], v[0], v[0], v[1]))
+            else:
+                px.append(tuple(v))
+        rows.append(px)
+    return w, h, rows
+
+
+def rgb565(r, g, b):
+    return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)
+
+
+def encode(path):
+    w, h, rows = read_png(path)
+    if w > 255 or h > 255:
+        raise ValueError("%s: sprites are limited to 255x255" % path)
+    indices, counts = [], {}
+    for row in rows:
+        for r, g, b, a in row:
+            c = None if a < 128 else rgb565(r, g, b)
+            indices.append(c)
+            if c is not None:
+                counts[c] = counts.get(c, 0) + 1
+    if len(counts) > 15:
+        raise ValueError("%s: %d colours, at most 15 fit a sprite palette" % (path, len(counts)))
+    pal = [0] + sorted(counts, key=lambda c: (-counts[c], c))
+    lookup = {c: i for i, c in enumerate(pal) if i}
+    rle = bytearray()
+    i = 0
+    while i < len(indices):
+        idx = lookup.get(indices[i], 0)
+        n = 1
+        while i + n < len(indices) and n < 16 and lookup.get(indices[i + n], 0) == idx:
+            n += 1
+        rle.append(((n - 1) << 4) | idx)
+        i += n
+    return w, h, pal, bytes(rle)
+
+
+def c_name(path):
+    return "icon_" + os.path.splitext(os.path.basename(path))[0].replace("-", "_")
+
+
+def main():
+    args = sys.argv[1:]
+    if len(args) < 3 or args[0] != "-o":
+        print(__doc__)
+        return 1
+    base, pngs = args[1], sorted(args[2:], key=c_name)
+    header = os.path.basename(base) + ".h"
+    src = ["// Generated by tools/png2sprite.py, do not edit", '#include "%s"' % header, ""]
+    hdr = ["// Generated by tools/png2sprite.py, do not edit", "#pragma once", '#include "display.h"', ""]
+    total_raw = total_rle = 0
+    for path in pngs:
+        name = c_name(path)
+        w, h, pal, rle = encode(path)
+        total_raw += w * h * 2
+        total_rle += len(rle) + len(pal) * 2
+        src.append("static const uint16_t %s_pal[%d] = { %s };" % (name, len(pal), ", ".join("0x%04X" % c for c in pal)))
+        src.append("static const uint8_t %s_rle[%d] = {" % (name, len(rle)))
+        for k in range(0, len(rle), 16):
+            src.append("    " + ", ".join("0x%02X" % b for b in rle[k:k + 16]) + ",")
+        src.append("};")
+        src.append("const Sprite %s = { %d, %d, %d, %s_pal, %s_rle };" % (name, w, h, len(pal), name, name))
+        src.append("")
+        hdr.append("extern const Sprite %s;" % name)
+    with open(base + ".c", "w") as f:
+        f.write("\n".join(src))
+    with open(base + ".h", "w") as f:
+        f.write("\n".join(hdr) + "\n")
+    print("png2sprite: %d sprites, %d bytes RGB565 -> %d bytes RLE" % (len(pngs), total_raw, total_rle))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
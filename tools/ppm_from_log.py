@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+"""Rebuild screenshots printed by display_model_dump() from a serial log.
+
+Usage: ppm_from_log.py monitor.log [out_prefix]
+
+Every "PPM P6 ..." block in the log becomes <out_prefix><n>.ppm and the
+checksum printed by the firmware is shown next to the file name.
+"""
+import sys
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    prefix = sys.argv[2] if len(sys.argv) > 2 else "screen"
+    shots, cur, size, crc = 0, None, None, None
+    with open(sys.argv[1], errors="replace") as f:
+        for line in f:
+            pos = line.find("PPM ")
+            if pos < 0:
+                continue
+            parts = line[pos:].split()
+            if parts[1] == "P6":
+                size = (int(parts[2]), int(parts[3]))
+                crc = parts[4] if len(parts) > 4 else "?"
+                cur = {}
+            elif parts[1] == "END" and cur is not None:
+                w, h = size
+                name = "%s%d.ppm" % (prefix, shots)
+                with open(name, "wb") as out:
+                    out.write(b"P6\n%d %d\n255\n" % (w, h))
+                    for y in range(h):
+                        out.write(cur.get(y, bytes(w * 3)))
+                print("%s  checksum %s" % (name, crc))
+                shots += 1
+                cur = None
+            elif cur is not None and len(parts) > 2:
+                cur[int(parts[1])] = bytes.fromhex(parts[2])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())